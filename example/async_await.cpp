@@ -2,7 +2,6 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
-#include <concurrent_queue.h>
 #include <lutask/future/Async.h>
 #include <lutask/ConditionVariableAny.h>
 #include <lutask/schedule/SharedWorkPolicy.h>
@@ -0,0 +1,80 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <vector>
+#include <lutask/Fiber.h>
+#include <lutask/ThreadPool.h>
+
+using Clock = std::chrono::steady_clock;
+
+// yields until every detached fiber has run
+static void drain(std::atomic_size_t const& done, std::size_t n)
+{
+    while (done.load(std::memory_order_acquire) < n)
+    {
+        lutask::this_fiber::Yield();
+    }
+}
+
+static long long elapsedUs(Clock::time_point start)
+{
+    return static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+}
+
+// n fibers one at a time and then in batches, on the calling fiber's scheduler
+static void compare(char const* where, std::size_t n)
+{
+    std::atomic_size_t done{ 0 };
+    auto work = [&done](std::size_t) { done.fetch_add(1, std::memory_order_release); };
+
+    // one at a time
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        lutask::Fiber(lutask::ELaunch::Post, std::allocator_arg, lutask::context::PooledFixedSizeStack(), work, i).Detach();
+    }
+    drain(done, n);
+    std::cout << where << ": " << n << " fibers by Fiber().Detach(): " << elapsedUs(start) << "us" << std::endl;
+
+    // one batch per Fiber::MaxBatch fibers
+    done.store(0);
+    start = Clock::now();
+    lutask::Fiber::Spawn(lutask::ELaunch::Post, std::size_t(0), n, work);
+    drain(done, n);
+    std::cout << where << ": " << n << " fibers by Fiber::Spawn(): " << elapsedUs(start) << "us" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t n = 100000;
+    if (argc > 1)
+    {
+        n = std::strtoul(argv[1], nullptr, 10);
+    }
+
+    // round robin on this thread: a batch saves the per-fiber attach lock
+    compare("round robin", n);
+
+    // work stealing: a batch wakes idle workers once and skips the attach
+    // that the policy would undo right away
+    {
+        lutask::ThreadPool pool;
+        pool.Async([n]() { compare("work stealing", n); return true; }).Get();
+    }
+
+    // one fiber per element
+    std::vector<int> values(1000);
+    std::iota(values.begin(), values.end(), 1);
+    long long sum = 0;
+    std::atomic_size_t done{ 0 };
+    lutask::Fiber::SpawnEach(lutask::ELaunch::Dispatch, values.begin(), values.end(), [&sum, &done](int v)
+    {
+        sum += v;
+        done.fetch_add(1, std::memory_order_release);
+    });
+    drain(done, values.size());
+    std::cout << "sum by Fiber::SpawnEach(): " << sum << std::endl;
+    return sum == 500500 ? 0 : 1;
+}
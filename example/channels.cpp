@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include <lutask/ConditionVariableAny.h>
+#include <lutask/Fiber.h>
+#include <lutask/channel/BufferedChannel.h>
+#include <lutask/channel/UnbufferedChannel.h>
+
+using Clock = std::chrono::steady_clock;
+
+// what callers had to write by hand before
+class LockedQueue
+{
+public:
+    void Push(int value)
+    {
+        std::unique_lock<std::mutex> lk(mtx_);
+        items_.push(value);
+        lk.unlock();
+        cnd_.NotifyOne();
+    }
+
+    void Close()
+    {
+        std::unique_lock<std::mutex> lk(mtx_);
+        closed_ = true;
+        lk.unlock();
+        cnd_.NotifyAll();
+    }
+
+    bool Pop(int& value)
+    {
+        std::unique_lock<std::mutex> lk(mtx_);
+        cnd_.Wait(lk, [this]() { return closed_ || items_.empty() == false; });
+        if (items_.empty())
+        {
+            return false;
+        }
+        value = items_.front();
+        items_.pop();
+        return true;
+    }
+
+private:
+    std::mutex mtx_;
+    lutask::ConditionVariableAny cnd_;
+    std::queue<int> items_;
+    bool closed_ = false;
+};
+
+template<typename Fn>
+void report(char const* name, std::size_t count, Fn fn)
+{
+    auto start = Clock::now();
+    long long sum = fn();
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    std::cout << name << ": " << count / elapsed.count() / 1e6 << " Mmsg/s"
+        << " (sum " << sum << ")" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t count = 1000000;
+    if (argc > 1)
+    {
+        count = std::strtoul(argv[1], nullptr, 10);
+    }
+
+    lutask::Fiber([count]()
+    {
+        report("mutex + std::queue + ConditionVariableAny", count, [count]()
+        {
+            LockedQueue queue;
+            lutask::Fiber producer([&queue, count]()
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    queue.Push(static_cast<int>(i));
+                }
+                queue.Close();
+            });
+            long long sum = 0;
+            int value = 0;
+            while (queue.Pop(value))
+            {
+                sum += value;
+            }
+            producer.Join();
+            return sum;
+        });
+
+        report("BufferedChannel Push/Pop", count, [count]()
+        {
+            lutask::BufferedChannel<int> chan(1024);
+            lutask::Fiber producer([&chan, count]()
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    chan.Push(static_cast<int>(i));
+                }
+                chan.Close();
+            });
+            long long sum = 0;
+            for (int value : chan)
+            {
+                sum += value;
+            }
+            producer.Join();
+            return sum;
+        });
+
+        report("BufferedChannel PushN/PopN", count, [count]()
+        {
+            lutask::BufferedChannel<int> chan(1024);
+            lutask::Fiber producer([&chan, count]()
+            {
+                std::vector<int> batch(256);
+                for (std::size_t i = 0; i < count; i += batch.size())
+                {
+                    std::size_t n = (std::min)(batch.size(), count - i);
+                    for (std::size_t j = 0; j < n; ++j)
+                    {
+                        batch[j] = static_cast<int>(i + j);
+                    }
+                    chan.PushN(batch.begin(), batch.begin() + n);
+                }
+                chan.Close();
+            });
+            long long sum = 0;
+            std::vector<int> batch(256);
+            while (std::size_t n = chan.PopN(batch.begin(), batch.size()))
+            {
+                for (std::size_t j = 0; j < n; ++j)
+                {
+                    sum += batch[j];
+                }
+            }
+            producer.Join();
+            return sum;
+        });
+
+        report("UnbufferedChannel", count / 10, [count]()
+        {
+            lutask::UnbufferedChannel<int> chan;
+            lutask::Fiber producer([&chan, count]()
+            {
+                for (std::size_t i = 0; i < count / 10; ++i)
+                {
+                    chan.Push(static_cast<int>(i));
+                }
+                chan.Close();
+            });
+            long long sum = 0;
+            for (int value : chan)
+            {
+                sum += value;
+            }
+            producer.Join();
+            return sum;
+        });
+
+        report("BufferedChannel, producer on another thread", count, [count]()
+        {
+            lutask::BufferedChannel<int> chan(1024);
+            std::thread producer([&chan, count]()
+            {
+                lutask::Fiber([&chan, count]()
+                {
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        chan.Push(static_cast<int>(i));
+                    }
+                    chan.Close();
+                }).Join();
+            });
+            long long sum = 0;
+            for (int value : chan)
+            {
+                sum += value;
+            }
+            producer.join();
+            return sum;
+        });
+
+        lutask::BufferedChannel<int> empty(2);
+        int value = 0;
+        bool timedOut = lutask::EChannelOp::Timeout == empty.PopWaitFor(value, std::chrono::milliseconds(10));
+        std::cout << "PopWaitFor on an empty channel timed out: " << timedOut << std::endl;
+    }).Join();
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <lutask/Fiber.h>
+#include <lutask/future/Future.h>
+#include <lutask/future/PackagedTask.h>
+#include <lutask/future/Promise.h>
+
+lutask::Future<int> compute(int value, std::chrono::milliseconds delay)
+{
+    lutask::PackagedTask<int()> pt([value, delay]()
+    {
+        lutask::this_fiber::sleep_for(delay);
+        return value;
+    });
+    lutask::Future<int> f = pt.GetFuture();
+    lutask::Fiber(std::move(pt)).Detach();
+    return f;
+}
+
+void run()
+{
+    // chained continuations
+    lutask::Future<std::string> chained = compute(20, std::chrono::milliseconds(10))
+        .Then([](lutask::Future<int> f) { return f.Get() + 1; })
+        .Then([](lutask::Future<int> f) { return std::to_string(f.Get() * 2); });
+    std::cout << "Then: " << chained.Get() << std::endl;
+
+    // fan-out and join on every result
+    std::vector<lutask::Future<int>> futures;
+    for (int i = 0; i < 8; ++i)
+    {
+        futures.push_back(compute(i, std::chrono::milliseconds(8 - i)));
+    }
+    int sum = 0;
+    for (lutask::Future<int>& f : lutask::WhenAll(futures.begin(), futures.end()).Get())
+    {
+        sum += f.Get();
+    }
+    std::cout << "WhenAll(range): " << sum << std::endl;
+
+    auto all = lutask::WhenAll(compute(1, std::chrono::milliseconds(5)), compute(2, std::chrono::milliseconds(1))).Get();
+    std::cout << "WhenAll(tuple): " << std::get<0>(all).Get() + std::get<1>(all).Get() << std::endl;
+
+    // first one wins, the others are still usable afterwards
+    auto any = lutask::WhenAny(compute(1, std::chrono::milliseconds(50)), compute(2, std::chrono::milliseconds(1))).Get();
+    std::cout << "WhenAny: index " << any.Index << ", late value " << std::get<0>(any.Futures).Get() << std::endl;
+
+    // a dropped promise breaks its future
+    lutask::Future<void> broken;
+    {
+        lutask::Promise<void> promise;
+        broken = promise.GetFuture();
+    }
+    try
+    {
+        broken.Get();
+    }
+    catch (lutask::BrokenPromise const& e)
+    {
+        std::cout << "Promise: " << e.what() << std::endl;
+    }
+}
+
+int main()
+{
+    // Get() from a worker fiber parks only that fiber,
+    // so the producers and continuations can run on this thread
+    lutask::Fiber(run).Join();
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <lutask/Fiber.h>
+
+using Clock = std::chrono::steady_clock;
+
+// fibers run on the main thread and are joined by other threads, every
+// Terminate() notifies a joiner parked on a foreign scheduler
+int main(int argc, char* argv[])
+{
+    std::size_t count = 10000;
+    std::size_t joiners = 4;
+    if (argc > 1)
+    {
+        count = std::strtoul(argv[1], nullptr, 10);
+    }
+    if (argc > 2)
+    {
+        joiners = std::strtoul(argv[2], nullptr, 10);
+    }
+
+    std::atomic_size_t joined{ 0 };
+    std::vector<std::vector<lutask::Fiber>> shares(joiners);
+    auto start = Clock::now();
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        shares[i % joiners].emplace_back([]()
+        {
+            lutask::this_fiber::Yield();
+        });
+    }
+
+    std::vector<std::thread> threads;
+    for (std::vector<lutask::Fiber>& share : shares)
+    {
+        threads.emplace_back([&share, &joined]()
+        {
+            for (lutask::Fiber& f : share)
+            {
+                f.Join();
+                joined.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    // keep running the fibers until every one of them was joined elsewhere
+    while (joined.load(std::memory_order_relaxed) < count)
+    {
+        lutask::this_fiber::Yield();
+    }
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+
+    auto elapsed = Clock::now() - start;
+    std::cout << count << " fibers joined from " << joiners << " threads: "
+        << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / count << " ns/fiber"
+        << std::endl;
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include <lutask/Fiber.h>
+#include <lutask/schedule/EdfPolicy.h>
+#include <lutask/schedule/RoundRobinPolicy.h>
+
+using Clock = std::chrono::steady_clock;
+
+static void spin(std::chrono::microseconds duration)
+{
+    auto end = Clock::now() + duration;
+    while (Clock::now() < end) {}
+}
+
+// requests arrive with deadlines in random order and yield between slices of
+// work; EDF finishes the urgent ones first instead of sharing time evenly
+template<typename Policy>
+void run(char const* name, std::size_t requests, std::size_t slices)
+{
+    lutask::Fiber::SetSchedulingPolicy<Policy>();
+
+    const std::chrono::microseconds slice(20);
+    const auto total = slice * requests * slices;
+    std::minstd_rand rng(42);
+    // about half the time until the last deadline is work, so EDF misses only
+    // the few due before the spawning is done
+    std::uniform_int_distribution<long long> spread(1, 2 * total.count());
+
+    std::size_t missed = 0;
+    std::vector<lutask::Fiber> fibers;
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < requests; ++i)
+    {
+        Clock::time_point deadline = start + std::chrono::microseconds(spread(rng)) + slice * slices;
+        fibers.emplace_back(deadline, [&missed, slice, slices, deadline]()
+        {
+            for (std::size_t j = 0; j < slices; ++j)
+            {
+                spin(slice);
+                lutask::this_fiber::Yield();
+            }
+            if (deadline < Clock::now())
+            {
+                ++missed;
+            }
+        });
+    }
+    for (lutask::Fiber& f : fibers)
+    {
+        f.Join();
+    }
+
+    std::cout << name << ": " << missed << " of " << requests << " requests missed their deadline in "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count() << " ms" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t requests = 200;
+    std::size_t slices = 10;
+    if (argc > 1)
+    {
+        requests = std::strtoul(argv[1], nullptr, 10);
+    }
+
+    // a thread installs its policy once, each run gets a thread of its own
+    std::thread([requests, slices]() { run<lutask::schedule::RoundRobinPolicy>("RoundRobinPolicy", requests, slices); }).join();
+    std::thread([requests, slices]() { run<lutask::schedule::EdfPolicy>("EdfPolicy", requests, slices); }).join();
+    std::cout << "misses seen by EdfPolicy at pick time: " << lutask::schedule::EdfPolicy::TotalDeadlineMisses() << std::endl;
+    return 0;
+}
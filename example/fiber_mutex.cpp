@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <lutask/Fiber.h>
+#include <lutask/Mutex.h>
+#include <lutask/schedule/SharedWorkPolicy.h>
+
+using Clock = std::chrono::steady_clock;
+
+static lutask::Mutex mtx;
+static long long counter = 0;
+static const std::size_t fiberCount = 16;
+
+// yields while holding the lock, with std::mutex the next fiber of the
+// same thread would block the thread and never let the owner finish
+void worker(std::size_t iterations)
+{
+    for (std::size_t i = 0; i < iterations; ++i)
+    {
+        std::unique_lock<lutask::Mutex> lk(mtx);
+        long long value = counter;
+        lutask::this_fiber::Yield();
+        counter = value + 1;
+    }
+}
+
+void timed()
+{
+    lutask::TimedMutex timedMtx;
+    lutask::Fiber holder([&timedMtx]()
+    {
+        std::unique_lock<lutask::TimedMutex> lk(timedMtx);
+        lutask::this_fiber::sleep_for(std::chrono::milliseconds(50));
+    });
+    lutask::this_fiber::Yield();
+
+    bool early = timedMtx.TryLockFor(std::chrono::milliseconds(10));
+    bool late = timedMtx.TryLockFor(std::chrono::milliseconds(500));
+    if (late)
+    {
+        timedMtx.Unlock();
+    }
+    holder.Join();
+
+    std::cout << "TryLockFor(10ms) while held: " << early
+        << ", TryLockFor(500ms): " << late << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t iterations = 10000;
+    if (argc > 1)
+    {
+        iterations = std::strtoul(argv[1], nullptr, 10);
+    }
+
+    // SharedWorkPolicy threads spin while idle, more of them than cores only adds noise
+    std::size_t threadCount = (std::max)(std::thread::hardware_concurrency(), 1u);
+    if (threadCount > 4)
+    {
+        threadCount = 4;
+    }
+    if (argc > 2)
+    {
+        threadCount = std::strtoul(argv[2], nullptr, 10);
+    }
+
+    lutask::Fiber(timed).Join();
+
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([iterations]()
+        {
+            // fibers migrate between the threads through the shared queue
+            lutask::Fiber::SetSchedulingPolicy<lutask::schedule::SharedWorkPolicy>();
+
+            std::vector<lutask::Fiber> fibers;
+            for (std::size_t i = 0; i < fiberCount; ++i)
+            {
+                fibers.emplace_back(worker, iterations);
+            }
+            for (lutask::Fiber& f : fibers)
+            {
+                f.Join();
+            }
+        });
+    }
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+    auto elapsed = Clock::now() - start;
+
+    const long long expected = static_cast<long long>(threadCount * fiberCount * iterations);
+    std::cout << "counter: " << counter << " expected: " << expected
+        << " (" << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / expected
+        << " ns/lock)" << std::endl;
+    return counter == expected ? 0 : 1;
+}
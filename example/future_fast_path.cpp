@@ -0,0 +1,144 @@
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <lutask/Fiber.h>
+#include <lutask/future/Future.h>
+#include <lutask/future/Promise.h>
+
+using Clock = std::chrono::steady_clock;
+
+// the previous SharedState path: every set and get takes the mutex
+// and the setter always notifies the condition variable
+class LockedState
+{
+public:
+    void SetValue(int value)
+    {
+        std::unique_lock<std::mutex> lk(mtx_);
+        value_ = value;
+        ready_ = true;
+        lk.unlock();
+        waiters_.notify_all();
+    }
+
+    int Get()
+    {
+        std::unique_lock<std::mutex> lk(mtx_);
+        lutask::Context::Active();
+        waiters_.wait(lk, [this]() { return ready_; });
+        return value_;
+    }
+
+private:
+    std::mutex mtx_;
+    std::condition_variable waiters_;
+    bool ready_ = false;
+    int value_ = 0;
+};
+
+static volatile long long sink = 0;
+
+// states are built outside the timed section, only set and get are measured
+template<typename State>
+std::chrono::nanoseconds set_then_get(std::size_t count)
+{
+    const std::size_t batch = 1000;
+    std::chrono::nanoseconds elapsed{ 0 };
+    for (std::size_t done = 0; done < count; done += batch)
+    {
+        std::unique_ptr<State[]> states(new State[batch]);
+        auto start = Clock::now();
+        for (std::size_t i = 0; i < batch; ++i)
+        {
+            states[i].SetValue(static_cast<int>(i));
+            sink = sink + states[i].Get();
+        }
+        elapsed += Clock::now() - start;
+    }
+    return elapsed;
+}
+
+// one thread fulfils the states while another one drains them in order
+template<typename State>
+std::chrono::nanoseconds producer_consumer(std::size_t count)
+{
+    const std::size_t batch = 1000;
+    std::chrono::nanoseconds elapsed{ 0 };
+    for (std::size_t done = 0; done < count; done += batch)
+    {
+        std::unique_ptr<State[]> states(new State[batch]);
+        auto start = Clock::now();
+        std::thread producer([&states, batch]()
+        {
+            for (std::size_t i = 0; i < batch; ++i)
+            {
+                states[i].SetValue(static_cast<int>(i));
+            }
+        });
+        for (std::size_t i = 0; i < batch; ++i)
+        {
+            sink = sink + states[i].Get();
+        }
+        producer.join();
+        elapsed += Clock::now() - start;
+    }
+    return elapsed;
+}
+
+std::chrono::nanoseconds std_future(std::size_t count)
+{
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        std::promise<int> promise;
+        std::future<int> future = promise.get_future();
+        promise.set_value(static_cast<int>(i));
+        sink = sink + future.get();
+    }
+    return Clock::now() - start;
+}
+
+// the consumer parks first, so every round goes through the slow path
+std::chrono::nanoseconds wait_then_set(std::size_t count)
+{
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        lutask::SharedState<int> state;
+        lutask::Fiber consumer(lutask::ELaunch::Dispatch, [&state]() { sink = sink + state.Get(); });
+        state.SetValue(static_cast<int>(i));
+        consumer.Join();
+    }
+    return Clock::now() - start;
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t count = 1000000;
+    if (argc > 1)
+    {
+        count = std::strtoul(argv[1], nullptr, 10);
+    }
+
+    auto locked = set_then_get<LockedState>(count);
+    auto atomic = set_then_get<lutask::SharedState<int>>(count);
+    auto standard = std_future(count);
+    auto lockedThreads = producer_consumer<LockedState>(count);
+    auto atomicThreads = producer_consumer<lutask::SharedState<int>>(count);
+    auto waiting = wait_then_set(count / 10);
+
+    std::cout << "set then get" << std::endl;
+    std::cout << "  mutex + condition_variable: " << locked.count() / count << " ns/op" << std::endl;
+    std::cout << "  SharedState fast path:      " << atomic.count() / count << " ns/op" << std::endl;
+    std::cout << "  std::promise/std::future:   " << standard.count() / count << " ns/op" << std::endl;
+    std::cout << "producer thread, consumer thread" << std::endl;
+    std::cout << "  mutex + condition_variable: " << lockedThreads.count() / count << " ns/op" << std::endl;
+    std::cout << "  SharedState fast path:      " << atomicThreads.count() / count << " ns/op" << std::endl;
+    std::cout << "consumer fiber waits first" << std::endl;
+    std::cout << "  SharedState slow path:      " << waiting.count() / (count / 10) << " ns/op" << std::endl;
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <lutask/Fiber.h>
+#include <lutask/ThreadPool.h>
+
+using Clock = std::chrono::steady_clock;
+
+static void spin(std::chrono::microseconds duration)
+{
+    auto end = Clock::now() + duration;
+    while (Clock::now() < end) {}
+}
+
+static void print(char const* name, lutask::LatencyHistogram const& h)
+{
+    std::cout << name << ": count=" << h.Count()
+        << " p50=" << h.Percentile(50) << "ns"
+        << " p90=" << h.Percentile(90) << "ns"
+        << " p99=" << h.Percentile(99) << "ns"
+        << " p99.9=" << h.Percentile(99.9) << "ns"
+        << " max=" << h.Max() << "ns" << std::endl;
+}
+
+// short requests share the workers with a few fibers that hog the cpu for a
+// while before yielding; the mean wait looks fine, the tail shows the hogs
+int main(int argc, char* argv[])
+{
+    std::size_t requests = 20000;
+    if (argc > 1)
+    {
+        requests = std::strtoul(argv[1], nullptr, 10);
+    }
+
+    lutask::ThreadPool pool(4);
+    pool.EnableLatencyHistograms();
+
+    for (std::size_t i = 0; i < requests; ++i)
+    {
+        pool.Post([i]()
+        {
+            const auto slice = 0 == i % 500 ? std::chrono::microseconds(500) : std::chrono::microseconds(2);
+            for (int j = 0; j < 3; ++j)
+            {
+                spin(slice);
+                lutask::this_fiber::Yield();
+            }
+        });
+    }
+    pool.Shutdown();
+
+    lutask::SchedulerLatency latency = pool.GetLatency();
+    std::cout << "ready wait mean " << static_cast<long long>(latency.ReadyWait.Mean()) << "ns" << std::endl;
+    print("ready wait", latency.ReadyWait);
+    print("run slice", latency.RunSlice);
+
+    std::cout << "ready wait as json: ";
+    latency.ReadyWait.WriteJson(std::cout);
+    std::cout << std::endl;
+    return 0;
+}
@@ -0,0 +1,155 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include <lutask/detail/MPMCQueue.h>
+
+using Clock = std::chrono::steady_clock;
+
+// the baseline every queue is compared against
+template<typename T>
+class LockedQueue
+{
+public:
+    void Push(T item)
+    {
+        std::unique_lock<std::mutex> lk(mtx_);
+        items_.push(item);
+    }
+
+    bool TryPop(T& item)
+    {
+        std::unique_lock<std::mutex> lk(mtx_);
+        if (items_.empty())
+        {
+            return false;
+        }
+        item = items_.front();
+        items_.pop();
+        return true;
+    }
+
+private:
+    std::mutex mtx_;
+    std::queue<T> items_;
+};
+
+// spins on a full ring, the producers simply outpace the consumers
+template<typename T>
+class BoundedQueue
+{
+public:
+    BoundedQueue() : queue_(4096) {}
+
+    void Push(T item)
+    {
+        lutask::detail::Backoff backoff;
+        while (queue_.TryPush(item) == false)
+        {
+            backoff.Snooze();
+        }
+    }
+
+    bool TryPop(T& item)
+    {
+        return queue_.TryPop(item);
+    }
+
+private:
+    lutask::detail::BoundedMPMCQueue<T> queue_;
+};
+
+// pairs producers and consumers, returns the number of items moved per second
+template<typename Queue>
+double throughput(std::size_t pairs, std::size_t perProducer)
+{
+    Queue queue;
+    std::atomic_bool go{ false };
+    std::atomic_size_t producing{ pairs };
+    std::atomic_size_t consumed{ 0 };
+    std::vector<std::thread> threads;
+
+    for (std::size_t p = 0; p < pairs; ++p)
+    {
+        threads.emplace_back([&queue, &go, &producing, perProducer]()
+        {
+            while (go.load(std::memory_order_acquire) == false)
+            {
+                std::this_thread::yield();
+            }
+            for (std::size_t i = 1; i <= perProducer; ++i)
+            {
+                queue.Push(i);
+            }
+            producing.fetch_sub(1, std::memory_order_release);
+        });
+        threads.emplace_back([&queue, &go, &producing, &consumed]()
+        {
+            while (go.load(std::memory_order_acquire) == false)
+            {
+                std::this_thread::yield();
+            }
+            lutask::detail::Backoff backoff;
+            std::size_t item = 0;
+            std::size_t count = 0;
+            for (;;)
+            {
+                if (queue.TryPop(item))
+                {
+                    ++count;
+                    backoff = lutask::detail::Backoff();
+                }
+                else if (producing.load(std::memory_order_acquire) != 0)
+                {
+                    backoff.Snooze();
+                }
+                else if (queue.TryPop(item) == false)
+                {
+                    break;
+                }
+                else
+                {
+                    ++count;
+                }
+            }
+            consumed.fetch_add(count, std::memory_order_relaxed);
+        });
+    }
+
+    auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    return consumed.load() / elapsed.count();
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t perProducer = 200000;
+    if (argc > 1)
+    {
+        perProducer = std::strtoul(argv[1], nullptr, 10);
+    }
+
+    std::cout << "pairs  mutex+std::queue  MPMCQueue  BoundedMPMCQueue  (Mitems/s)" << std::endl;
+    for (std::size_t pairs : { 1, 2, 4, 8, 16 })
+    {
+        double locked = throughput<LockedQueue<std::size_t>>(pairs, perProducer);
+        double unbounded = throughput<lutask::detail::MPMCQueue<std::size_t>>(pairs, perProducer);
+        double bounded = throughput<BoundedQueue<std::size_t>>(pairs, perProducer);
+
+        std::cout << pairs
+            << "\t" << locked / 1e6
+            << "\t" << unbounded / 1e6
+            << "\t" << bounded / 1e6 << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <lutask/Fiber.h>
+#include <lutask/ThreadPool.h>
+#include <lutask/Topology.h>
+
+// pinned workers fill one node before the next, fibers spawned by a task land
+// on its worker's deque and idle workers steal them, same node first
+int main(int argc, char* argv[])
+{
+    std::size_t tasks = 1000;
+    std::size_t fibers = 100;
+    if (argc > 1)
+    {
+        tasks = std::strtoul(argv[1], nullptr, 10);
+    }
+
+    for (std::size_t i = 0; i < lutask::Topology::NodeCount(); ++i)
+    {
+        lutask::NumaNode const& node = lutask::Topology::Node(i);
+        std::cout << "node " << node.Id << ":";
+        for (std::size_t cpu : node.Cpus)
+        {
+            std::cout << " " << cpu;
+        }
+        std::cout << std::endl;
+    }
+
+    std::atomic_size_t done{ 0 };
+    {
+        lutask::ThreadPool pool((std::max)(lutask::Topology::CpuCount(), static_cast<std::size_t>(2)),
+            lutask::ThreadPool::DefaultPolicy(), true);
+        for (std::size_t i = 0; i < tasks; ++i)
+        {
+            pool.Post([&done, fibers]()
+            {
+                for (std::size_t j = 0; j < fibers; ++j)
+                {
+                    lutask::Fiber(lutask::ELaunch::Async, [&done]()
+                    {
+                        lutask::this_fiber::Yield();
+                        done.fetch_add(1, std::memory_order_relaxed);
+                    }).Detach();
+                }
+            });
+        }
+    }
+
+    std::cout << done.load() << " fibers done" << std::endl;
+    for (std::size_t i = 0; i < lutask::Topology::NodeCount(); ++i)
+    {
+        lutask::NumaNodeStats stats = lutask::Topology::Stats(i);
+        std::cout << "node " << lutask::Topology::Node(i).Id
+            << ": local steals " << stats.LocalSteals
+            << ", remote steals " << stats.RemoteSteals
+            << ", migrated out " << stats.MigrationsOut
+            << ", bind failures " << stats.BindFailures << std::endl;
+    }
+    return 0;
+}
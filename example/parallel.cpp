@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <lutask/Parallel.h>
+#include <lutask/ThreadPool.h>
+
+// ParallelReduce, ParallelTransform and ParallelInvoke on a ThreadPool
+// against a serial loop and one std::thread per core over equal chunks.
+//
+//   parallel [--quick]
+
+using Clock = std::chrono::steady_clock;
+
+static double work(std::size_t i)
+{
+    return std::sqrt(static_cast<double>(i)) * std::sin(static_cast<double>(i));
+}
+
+// best of runs, in ms
+static double bestOf(std::size_t runs, std::function<void()> const& fn)
+{
+    double best = 1e300;
+    for (std::size_t i = 0; i < runs; ++i)
+    {
+        auto start = Clock::now();
+        fn();
+        best = (std::min)(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+static void report(char const* name, double serialMs, double ms)
+{
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(2)
+        << std::setw(10) << ms << "ms" << std::setw(8) << serialMs / ms << "x" << std::endl;
+}
+
+// one contiguous chunk per thread
+template<typename Fn>
+static void threadChunks(std::size_t threads, std::size_t n, Fn const& fn)
+{
+    std::vector<std::thread> pool;
+    for (std::size_t t = 0; t < threads; ++t)
+    {
+        pool.emplace_back([&fn, t, threads, n]() { fn(t, n * t / threads, n * (t + 1) / threads); });
+    }
+    for (std::thread& th : pool)
+    {
+        th.join();
+    }
+}
+
+static void quicksort(std::vector<int>::iterator first, std::vector<int>::iterator last)
+{
+    if (last - first < 4096)
+    {
+        std::sort(first, last);
+        return;
+    }
+
+    const int pivot = *(first + (last - first) / 2);
+    auto middle1 = std::partition(first, last, [pivot](int v) { return v < pivot; });
+    auto middle2 = std::partition(middle1, last, [pivot](int v) { return !(pivot < v); });
+    lutask::ParallelInvoke(
+        [first, middle1]() { quicksort(first, middle1); },
+        [middle2, last]() { quicksort(middle2, last); });
+}
+
+int main(int argc, char* argv[])
+{
+    const bool quick = argc > 1 && 0 == std::strcmp(argv[1], "--quick");
+    const std::size_t n = quick ? 1000000 : 10000000;
+    const std::size_t runs = quick ? 2 : 5;
+    const std::size_t threads = (std::max)(std::thread::hardware_concurrency(), 1u);
+    const std::size_t grain = 4096;
+    bool ok = true;
+
+    lutask::ThreadPool pool(threads);
+    // the algorithms join from a fiber, so the caller runs inside the pool
+    auto inPool = [&pool](std::function<void()> fn)
+    {
+        pool.Async([&fn]() { fn(); return true; }).Get();
+    };
+
+    std::cout << n << " elements, " << threads << " threads" << std::endl;
+
+    // reduce
+    double expected = 0;
+    const double serialReduce = bestOf(runs, [&]()
+    {
+        expected = 0;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            expected += work(i);
+        }
+    });
+    report("reduce serial", serialReduce, serialReduce);
+
+    double sum = 0;
+    report("reduce std::thread", serialReduce, bestOf(runs, [&]()
+    {
+        std::vector<double> partial(threads);
+        threadChunks(threads, n, [&partial](std::size_t t, std::size_t b, std::size_t e)
+        {
+            for (; b != e; ++b)
+            {
+                partial[t] += work(b);
+            }
+        });
+        sum = std::accumulate(partial.begin(), partial.end(), 0.0);
+    }));
+    ok = ok && std::abs(sum - expected) <= 1e-6 * std::abs(expected);
+
+    report("ParallelReduce", serialReduce, bestOf(runs, [&]()
+    {
+        inPool([&]()
+        {
+            sum = lutask::ParallelReduce(std::size_t(0), n, grain, 0.0, work, std::plus<double>());
+        });
+    }));
+    ok = ok && std::abs(sum - expected) <= 1e-6 * std::abs(expected);
+
+    // transform
+    std::vector<std::size_t> input(n);
+    std::iota(input.begin(), input.end(), std::size_t(0));
+    std::vector<double> output(n);
+    const double serialTransform = bestOf(runs, [&]()
+    {
+        std::transform(input.begin(), input.end(), output.begin(), work);
+    });
+    report("transform serial", serialTransform, serialTransform);
+
+    report("transform std::thread", serialTransform, bestOf(runs, [&]()
+    {
+        threadChunks(threads, n, [&](std::size_t, std::size_t b, std::size_t e)
+        {
+            std::transform(input.begin() + b, input.begin() + e, output.begin() + b, work);
+        });
+    }));
+
+    std::fill(output.begin(), output.end(), 0.0);
+    report("ParallelTransform", serialTransform, bestOf(runs, [&]()
+    {
+        inPool([&]()
+        {
+            lutask::ParallelTransform(input.begin(), input.end(), output.begin(), grain, work);
+        });
+    }));
+    ok = ok && output[n - 1] == work(n - 1);
+
+    // ParallelFor over an index range
+    std::vector<unsigned char> touched(n, 0);
+    inPool([&]()
+    {
+        lutask::ParallelFor(std::size_t(0), n, grain, [&touched](std::size_t i) { ++touched[i]; });
+    });
+    ok = ok && std::all_of(touched.begin(), touched.end(), [](unsigned char c) { return 1 == c; });
+
+    // sort, recursive ParallelInvoke
+    std::vector<int> values(n);
+    std::mt19937 rng(42);
+    std::generate(values.begin(), values.end(), [&rng]() { return static_cast<int>(rng()); });
+    std::vector<int> data;
+    const double serialSort = bestOf(runs, [&]()
+    {
+        data = values;
+        std::sort(data.begin(), data.end());
+    });
+    report("sort std::sort", serialSort, serialSort);
+
+    report("sort ParallelInvoke", serialSort, bestOf(runs, [&]()
+    {
+        data = values;
+        inPool([&]() { quicksort(data.begin(), data.end()); });
+    }));
+    ok = ok && std::is_sorted(data.begin(), data.end());
+
+    // the first exception of a part comes back to the caller
+    bool caught = false;
+    inPool([&]()
+    {
+        try
+        {
+            lutask::ParallelFor(0, 1000, 10, [](int i)
+            {
+                if (500 == i)
+                    throw std::runtime_error("part failed");
+            });
+        }
+        catch (std::runtime_error const&)
+        {
+            caught = true;
+        }
+    });
+    ok = ok && caught;
+
+    std::cout << (ok ? "results match" : "results differ") << std::endl;
+    return ok ? 0 : 1;
+}
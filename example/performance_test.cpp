@@ -0,0 +1,501 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include <lutask/ConditionVariableAny.h>
+#include <lutask/Fiber.h>
+#include <lutask/context/PooledFixedSizeStack.h>
+#include <lutask/context/fcontext.h>
+#include <lutask/future/Async.h>
+#include <lutask/schedule/SharedWorkPolicy.h>
+
+// Microbenchmarks of the fiber primitives. Every benchmark runs a number of
+// samples of a batch of operations each; ns/op is the mean over all of them.
+// p50, p90, p99 and max are percentiles of the per-batch means, not of single
+// operations: a batch of 1000 yields with one slow yield in it still looks
+// fast, so they show jitter between batches, not the tail of one operation.
+//
+// allocs/op counts every trip to the heap. On glibc the program replaces the
+// whole malloc family (malloc, calloc, realloc, reallocarray, posix_memalign,
+// aligned_alloc, memalign, valloc, pvalloc) with counting wrappers around
+// glibc's own, which sees operator new, the malloc of a FixedSizeStack and
+// the stack pool's misses alike. Elsewhere only the global operator new and
+// the stack pool's misses are counted, and stacks of a plain FixedSizeStack
+// are missing from the figure.
+//
+//   performance_test [--json] [--quick]
+//
+// --json prints one object for the whole run, for tracking numbers across
+// releases; --quick runs a tenth of the iterations.
+
+using Clock = std::chrono::steady_clock;
+
+static std::atomic_size_t allocations{ 0 };
+
+#if defined(__GLIBC__)
+// glibc's own entry points; the replacements below cover every function of
+// the family glibc lets a program replace that allocates, and report the
+// errors of the argument checks the wrappers do themselves
+extern "C"
+{
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* vp, std::size_t size);
+void* __libc_memalign(std::size_t alignment, std::size_t size);
+void* __libc_valloc(std::size_t size);
+void* __libc_pvalloc(std::size_t size);
+void __libc_free(void* vp);
+}
+
+static void CountAllocation()
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+static bool IsPowerOfTwo(std::size_t n)
+{
+    return 0 != n && 0 == (n & (n - 1));
+}
+
+extern "C"
+{
+void* malloc(std::size_t size)
+{
+    CountAllocation();
+    return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size)
+{
+    CountAllocation();
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* vp, std::size_t size)
+{
+    CountAllocation();
+    return __libc_realloc(vp, size);
+}
+
+void* reallocarray(void* vp, std::size_t count, std::size_t size)
+{
+    if (0 != size && count > (std::numeric_limits<std::size_t>::max)() / size)
+    {
+        errno = ENOMEM;
+        return nullptr;
+    }
+    CountAllocation();
+    return __libc_realloc(vp, count * size);
+}
+
+int posix_memalign(void** vp, std::size_t alignment, std::size_t size)
+{
+    if (!IsPowerOfTwo(alignment) || 0 != alignment % sizeof(void*))
+        return EINVAL;
+
+    CountAllocation();
+    void* block = __libc_memalign(alignment, size);
+    if (nullptr == block)
+        return ENOMEM;
+    *vp = block;
+    return 0;
+}
+
+void* aligned_alloc(std::size_t alignment, std::size_t size)
+{
+    if (!IsPowerOfTwo(alignment))
+    {
+        errno = EINVAL;
+        return nullptr;
+    }
+    CountAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+void* memalign(std::size_t alignment, std::size_t size)
+{
+    CountAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+void* valloc(std::size_t size)
+{
+    CountAllocation();
+    return __libc_valloc(size);
+}
+
+void* pvalloc(std::size_t size)
+{
+    CountAllocation();
+    return __libc_pvalloc(size);
+}
+
+void free(void* vp)
+{
+    __libc_free(vp);
+}
+}
+
+static std::size_t CountAllocations()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+#else
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* vp = std::malloc(0 != size ? size : 1))
+        return vp;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* vp) noexcept
+{
+    std::free(vp);
+}
+
+void operator delete(void* vp, std::size_t) noexcept
+{
+    std::free(vp);
+}
+
+static std::size_t CountAllocations()
+{
+    return allocations.load(std::memory_order_relaxed) + lutask::context::StackPool::Stats().Misses;
+}
+#endif
+
+struct Result
+{
+    std::string name;
+    std::size_t ops = 0;
+    double nsPerOp = 0;
+    double p50 = 0;
+    double p90 = 0;
+    double p99 = 0;
+    double max = 0;
+    double allocsPerOp = 0;
+};
+
+static std::vector<Result> results;
+// keeps results the compiler could otherwise drop
+static volatile std::size_t sink = 0;
+
+// fn(batch) performs batch operations and returns how many it did
+static void Measure(std::string const& name, std::size_t samples, std::size_t batch,
+    std::function<std::size_t(std::size_t)> const& fn)
+{
+    // warm caches and pools
+    fn(batch);
+
+    std::vector<double> perOp;
+    perOp.reserve(samples);
+    std::size_t ops = 0;
+    const std::size_t allocsBefore = CountAllocations();
+    Clock::duration total{ 0 };
+    for (std::size_t i = 0; i < samples; ++i)
+    {
+        auto start = Clock::now();
+        std::size_t done = fn(batch);
+        auto elapsed = Clock::now() - start;
+        total += elapsed;
+        ops += done;
+        perOp.push_back(static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / done);
+    }
+    const std::size_t allocs = CountAllocations() - allocsBefore;
+
+    std::sort(perOp.begin(), perOp.end());
+    auto percentile = [&perOp](double p)
+    {
+        return perOp[static_cast<std::size_t>(p * (perOp.size() - 1))];
+    };
+
+    Result r;
+    r.name = name;
+    r.ops = ops;
+    r.nsPerOp = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(total).count()) / ops;
+    r.p50 = percentile(0.50);
+    r.p90 = percentile(0.90);
+    r.p99 = percentile(0.99);
+    r.max = perOp.back();
+    r.allocsPerOp = static_cast<double>(allocs) / ops;
+    results.push_back(r);
+}
+
+// two raw contexts bouncing; one op is one jump
+static void BenchJumpFcontext(std::size_t scale)
+{
+    namespace ctx = lutask::context;
+
+    const std::size_t size = 64 * 1024;
+    void* stack = std::malloc(size);
+    ctx::fcontext_t other = ctx::make_fcontext(static_cast<char*>(stack) + size, size, [](ctx::transfer_t t)
+    {
+        for (;;)
+        {
+            t = ctx::jump_fcontext(t.fctx, nullptr);
+        }
+    });
+
+    Measure("jump_fcontext", 100 * scale, 1000, [&other](std::size_t batch)
+    {
+        for (std::size_t i = 0; i < batch; ++i)
+        {
+            other = ctx::jump_fcontext(other, nullptr).fctx;
+        }
+        return 2 * batch;
+    });
+
+    // the other side is parked in its loop for good, nothing to unwind
+    std::free(stack);
+}
+
+static void BenchCreateJoin(std::size_t scale)
+{
+    Measure("fiber_create_join", 100 * scale, 100, [](std::size_t batch)
+    {
+        for (std::size_t i = 0; i < batch; ++i)
+        {
+            lutask::Fiber([]() {}).Join();
+        }
+        return batch;
+    });
+
+    Measure("fiber_create_join_pooled", 100 * scale, 100, [](std::size_t batch)
+    {
+        for (std::size_t i = 0; i < batch; ++i)
+        {
+            lutask::Fiber(lutask::ELaunch::Post, std::allocator_arg, lutask::context::PooledFixedSizeStack(), []() {}).Join();
+        }
+        return batch;
+    });
+}
+
+// two fibers yielding to each other; one op is one yield
+static void BenchYield(std::size_t scale)
+{
+    Measure("yield_ping_pong", 100 * scale, 1000, [](std::size_t batch)
+    {
+        auto loop = [batch]()
+        {
+            for (std::size_t i = 0; i < batch; ++i)
+            {
+                lutask::this_fiber::Yield();
+            }
+        };
+        lutask::Fiber a(loop);
+        lutask::Fiber b(loop);
+        a.Join();
+        b.Join();
+        return 2 * batch;
+    });
+}
+
+// on the default scheduler Async() runs the fiber on the calling thread,
+// Get() from the thread itself suspends it until the fiber has run
+static void BenchAsync(std::size_t scale)
+{
+    std::thread([scale]()
+    {
+        Measure("async_future_get", 100 * scale, 100, [](std::size_t batch)
+        {
+            for (std::size_t i = 0; i < batch; ++i)
+            {
+                sink += lutask::Async([](std::size_t n) { return n; }, i).Get();
+            }
+            return batch;
+        });
+    }).join();
+}
+
+// every fiber starts ten children until a million leaves each return their
+// number; dispatch launches keep it depth first, so only a few stacks are live
+static std::uint64_t Skynet(std::uint64_t num, std::uint64_t size)
+{
+    if (1 == size)
+        return num;
+
+    std::uint64_t sums[10] = {};
+    std::vector<lutask::Fiber> children;
+    children.reserve(10);
+    const std::uint64_t part = size / 10;
+    for (std::uint64_t i = 0; i < 10; ++i)
+    {
+        children.emplace_back(lutask::ELaunch::Dispatch, std::allocator_arg, lutask::context::PooledFixedSizeStack(),
+            [&sums, i, num, part]() { sums[i] = Skynet(num + i * part, part); });
+    }
+    std::uint64_t sum = 0;
+    for (std::uint64_t i = 0; i < 10; ++i)
+    {
+        children[i].Join();
+        sum += sums[i];
+    }
+    return sum;
+}
+
+static void BenchSkynet(std::size_t scale)
+{
+    const std::uint64_t leaves = 1 == scale ? 100000 : 1000000;
+    const std::uint64_t fibers = leaves + leaves / 9;
+    Measure(1 == scale ? "skynet_100k" : "skynet_1m", 1 == scale ? 3 : 5, 1, [leaves, fibers](std::size_t)
+    {
+        std::uint64_t sum = Skynet(0, leaves);
+        if (sum != leaves * (leaves - 1) / 2)
+        {
+            std::cerr << "skynet: wrong sum " << sum << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+        return static_cast<std::size_t>(fibers);
+    });
+}
+
+// fibers posted on one SharedWorkPolicy thread, run by all of them; the
+// helper threads start once per thread count, a sample times only the post
+// and drain of its batch
+static void BenchSharedWork(std::size_t scale)
+{
+    std::vector<std::size_t> counts{ 1, 2, 4 };
+    for (std::size_t n = 8; n <= std::thread::hardware_concurrency(); n *= 2)
+    {
+        counts.push_back(n);
+    }
+
+    for (std::size_t threadCount : counts)
+    {
+        std::thread([threadCount, scale]()
+        {
+            lutask::Fiber::SetSchedulingPolicy<lutask::schedule::SharedWorkPolicy>();
+
+            std::mutex mtx;
+            lutask::ConditionVariableAny drained;
+            lutask::ConditionVariableAny stopped;
+            std::size_t left = 0;
+            bool stop = false;
+
+            // waiting on a fiber condition keeps the dispatcher running shared fibers
+            std::vector<std::thread> helpers;
+            for (std::size_t i = 1; i < threadCount; ++i)
+            {
+                helpers.emplace_back([&mtx, &stopped, &stop]()
+                {
+                    lutask::Fiber::SetSchedulingPolicy<lutask::schedule::SharedWorkPolicy>();
+                    std::unique_lock<std::mutex> lk(mtx);
+                    stopped.Wait(lk, [&stop]() { return stop; });
+                });
+            }
+
+            auto work = [&mtx, &drained, &left]()
+            {
+                std::unique_lock<std::mutex> lk(mtx);
+                if (0 == --left)
+                {
+                    lk.unlock();
+                    drained.NotifyAll();
+                }
+            };
+
+            Measure("shared_work_" + std::to_string(threadCount) + "t", 10 * scale, 1000, [&](std::size_t batch)
+            {
+                {
+                    std::unique_lock<std::mutex> lk(mtx);
+                    left = batch;
+                }
+                for (std::size_t i = 0; i < batch; ++i)
+                {
+                    lutask::Fiber(lutask::ELaunch::Post, std::allocator_arg, lutask::context::PooledFixedSizeStack(), work).Detach();
+                }
+                std::unique_lock<std::mutex> lk(mtx);
+                drained.Wait(lk, [&left]() { return 0 == left; });
+                return batch;
+            });
+
+            {
+                std::unique_lock<std::mutex> lk(mtx);
+                stop = true;
+            }
+            stopped.NotifyAll();
+            for (std::thread& t : helpers)
+            {
+                t.join();
+            }
+        }).join();
+    }
+}
+
+static void PrintTable()
+{
+    std::cout << std::left << std::setw(28) << "benchmark" << std::right
+        << std::setw(12) << "ops" << std::setw(12) << "ns/op" << std::setw(12) << "p50"
+        << std::setw(12) << "p90" << std::setw(12) << "p99" << std::setw(12) << "max"
+        << std::setw(12) << "allocs/op" << '\n';
+    std::cout << std::fixed << std::setprecision(1);
+    for (Result const& r : results)
+    {
+        std::cout << std::left << std::setw(28) << r.name << std::right
+            << std::setw(12) << r.ops << std::setw(12) << r.nsPerOp << std::setw(12) << r.p50
+            << std::setw(12) << r.p90 << std::setw(12) << r.p99 << std::setw(12) << r.max
+            << std::setw(12) << std::setprecision(3) << r.allocsPerOp << std::setprecision(1) << '\n';
+    }
+    std::cout << "p50..max are percentiles of per-batch means in ns/op, not of single operations\n";
+}
+
+static void PrintJson()
+{
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "{\"hardware_concurrency\":" << std::thread::hardware_concurrency()
+        << ",\"percentiles_of\":\"batch_means\",\"benchmarks\":[";
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        Result const& r = results[i];
+        std::cout << (0 == i ? "\n" : ",\n")
+            << "{\"name\":\"" << r.name << "\",\"ops\":" << r.ops
+            << ",\"ns_per_op\":" << r.nsPerOp << ",\"p50_ns\":" << r.p50 << ",\"p90_ns\":" << r.p90
+            << ",\"p99_ns\":" << r.p99 << ",\"max_ns\":" << r.max << ",\"allocs_per_op\":" << r.allocsPerOp << "}";
+    }
+    std::cout << "\n]}" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    bool json = false;
+    std::size_t scale = 10;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == std::strcmp(argv[i], "--json"))
+        {
+            json = true;
+        }
+        else if (0 == std::strcmp(argv[i], "--quick"))
+        {
+            scale = 1;
+        }
+    }
+
+    BenchJumpFcontext(scale);
+    BenchCreateJoin(scale);
+    BenchYield(scale);
+    BenchAsync(scale);
+    BenchSkynet(scale);
+    BenchSharedWork(scale);
+
+    if (json)
+    {
+        PrintJson();
+    }
+    else
+    {
+        PrintTable();
+    }
+    return 0;
+}
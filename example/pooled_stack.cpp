@@ -0,0 +1,64 @@
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <lutask/Fiber.h>
+#include <lutask/context/PooledFixedSizeStack.h>
+
+// Spawns rounds of width fibers with plain and pooled stacks. With the
+// default 64 KiB stack malloc itself recycles the freed chunks, so the pool
+// mostly saves the allocator's bookkeeping and wins little. Stacks above
+// glibc's mmap threshold (128 KiB until the first such free) cost malloc an
+// mmap, page faults on first touch and a munmap or trim when released; the
+// pool hands back stacks whose pages are already mapped and warm.
+
+static std::size_t counter{ 0 };
+
+void fn(std::size_t n)
+{
+    counter += n;
+    lutask::this_fiber::Yield();
+}
+
+template<typename StackAllocator>
+std::chrono::nanoseconds spawn(std::size_t rounds, std::size_t width, std::size_t stackSize)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<lutask::Fiber> fibers;
+    fibers.reserve(width);
+    for (std::size_t r = 0; r < rounds; ++r)
+    {
+        for (std::size_t i = 0; i < width; ++i)
+        {
+            fibers.emplace_back(lutask::ELaunch::Post, std::allocator_arg, StackAllocator(stackSize), fn, i);
+        }
+        for (lutask::Fiber& f : fibers)
+        {
+            f.Join();
+        }
+        fibers.clear();
+    }
+    return std::chrono::steady_clock::now() - start;
+}
+
+int main()
+{
+    const std::size_t rounds = 1000;
+    const std::size_t width = 100;
+
+    for (std::size_t stackSize : { lutask::StackTraits::DefaultSize(), std::size_t(1024 * 1024) })
+    {
+        auto plain = spawn<lutask::context::FixedSizeStack>(rounds, width, stackSize);
+        auto pooled = spawn<lutask::context::PooledFixedSizeStack>(rounds, width, stackSize);
+
+        std::cout << stackSize / 1024 << " KiB stacks" << std::endl;
+        std::cout << "  FixedSizeStack:       " << plain.count() / (rounds * width) << " ns/fiber" << std::endl;
+        std::cout << "  PooledFixedSizeStack: " << pooled.count() / (rounds * width) << " ns/fiber" << std::endl;
+    }
+
+    lutask::context::StackPoolStats stats = lutask::context::StackPool::Stats();
+    std::cout << "hits: " << stats.Hits
+        << " misses: " << stats.Misses
+        << " cached: " << stats.Cached
+        << " high-water: " << stats.HighWater << std::endl;
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <lutask/Fiber.h>
+#include <lutask/schedule/PriorityPolicy.h>
+#include <lutask/schedule/RoundRobinPolicy.h>
+
+using Clock = std::chrono::steady_clock;
+
+// background fibers keep yielding while a request fiber measures how long each
+// of its yields takes to come back; with priorities it only waits for aging turns
+template<typename Policy>
+void run(char const* name, std::size_t background, std::size_t rounds)
+{
+    lutask::Fiber::SetSchedulingPolicy<Policy>();
+
+    bool stop = false;
+    std::size_t backgroundTurns = 0;
+    std::vector<lutask::Fiber> fibers;
+    for (std::size_t i = 0; i < background; ++i)
+    {
+        fibers.emplace_back(lutask::EPriority::Low, [&stop, &backgroundTurns]()
+        {
+            while (stop == false)
+            {
+                ++backgroundTurns;
+                lutask::this_fiber::Yield();
+            }
+        });
+    }
+
+    std::vector<double> latencies;
+    lutask::Fiber request(lutask::EPriority::Critical, [&latencies, rounds]()
+    {
+        for (std::size_t i = 0; i < rounds; ++i)
+        {
+            auto start = Clock::now();
+            lutask::this_fiber::Yield();
+            latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+    });
+    request.Join();
+
+    // promoted at runtime, the last background fiber now runs ahead of the others
+    fibers.back().SetPriority(lutask::EPriority::High);
+    stop = true;
+    for (lutask::Fiber& f : fibers)
+    {
+        f.Join();
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << name << ": yield round trip p50 " << latencies[latencies.size() / 2]
+        << " us, p99 " << latencies[latencies.size() * 99 / 100]
+        << " us (" << backgroundTurns << " background turns)" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t background = 200;
+    std::size_t rounds = 10000;
+    if (argc > 1)
+    {
+        background = std::strtoul(argv[1], nullptr, 10);
+    }
+
+    // a thread installs its policy once, each run gets a thread of its own
+    std::thread([background, rounds]() { run<lutask::schedule::RoundRobinPolicy>("RoundRobinPolicy", background, rounds); }).join();
+    std::thread([background, rounds]() { run<lutask::schedule::PriorityPolicy>("PriorityPolicy", background, rounds); }).join();
+    return 0;
+}
@@ -0,0 +1,52 @@
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include <lutask/Fiber.h>
+#include <lutask/ConditionVariableAny.h>
+#include <lutask/context/ProtectedFixedSizeStack.h>
+
+static std::mutex mtx{};
+static lutask::ConditionVariableAny cnd{};
+static bool released{ false };
+
+void idle(std::size_t touch)
+{
+    // touch a little stack, then park
+    volatile char buffer[1024];
+    std::memset(const_cast<char*>(buffer), 0, (std::min)(touch, sizeof(buffer)));
+
+    std::unique_lock<std::mutex> lk(mtx);
+    cnd.Wait(lk, []() { return released; });
+}
+
+int main()
+{
+    const std::size_t fiber_total = 10000;
+    const std::size_t stack_size = 64 * 1024;
+
+    std::vector<lutask::Fiber> fibers;
+    fibers.reserve(fiber_total);
+    for (std::size_t i = 0; i < fiber_total; ++i)
+    {
+        fibers.emplace_back(lutask::ELaunch::Dispatch, std::allocator_arg,
+            lutask::context::ProtectedFixedSizeStack(stack_size), idle, i);
+    }
+
+    lutask::context::ProtectedStackStats stats = lutask::context::ProtectedStackRegistry::Stats();
+    std::cout << "stacks: " << stats.Stacks
+        << " reserved: " << stats.ReservedBytes / 1024 << " KiB"
+        << " resident: " << stats.ResidentBytes / 1024 << " KiB" << std::endl;
+
+    {
+        std::unique_lock<std::mutex> lk(mtx);
+        released = true;
+    }
+    cnd.NotifyAll();
+
+    for (lutask::Fiber& f : fibers)
+    {
+        f.Join();
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <lutask/Fiber.h>
+#include <lutask/future/Future.h>
+#include <lutask/future/Promise.h>
+
+using Clock = std::chrono::steady_clock;
+
+// fibers of the main thread wait on promises that plain threads fulfil,
+// every wakeup crosses threads and goes through the scheduler's inbox
+int main(int argc, char* argv[])
+{
+    std::size_t rounds = 10000;
+    std::size_t producers = 4;
+    if (argc > 1)
+    {
+        rounds = std::strtoul(argv[1], nullptr, 10);
+    }
+    if (argc > 2)
+    {
+        producers = std::strtoul(argv[2], nullptr, 10);
+    }
+
+    const std::size_t fibers = 64;
+    long long sum = 0;
+    auto start = Clock::now();
+
+    for (std::size_t round = 0; round < rounds / fibers; ++round)
+    {
+        std::vector<lutask::Promise<int>> promises(fibers);
+        std::vector<lutask::Future<int>> futures;
+        std::vector<lutask::Fiber> waiters;
+        for (std::size_t i = 0; i < fibers; ++i)
+        {
+            futures.push_back(promises[i].GetFuture());
+        }
+        for (std::size_t i = 0; i < fibers; ++i)
+        {
+            lutask::Future<int>* future = &futures[i];
+            waiters.emplace_back([&sum, future]() { sum += future->Get(); });
+        }
+
+        std::vector<std::thread> threads;
+        for (std::size_t p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&promises, p, producers, fibers]()
+            {
+                for (std::size_t i = p; i < fibers; i += producers)
+                {
+                    promises[i].SetValue(static_cast<int>(i));
+                }
+            });
+        }
+
+        for (lutask::Fiber& f : waiters)
+        {
+            f.Join();
+        }
+        for (std::thread& t : threads)
+        {
+            t.join();
+        }
+    }
+
+    auto elapsed = Clock::now() - start;
+    std::size_t woken = rounds / fibers * fibers;
+    std::cout << woken << " remote wakeups from " << producers << " threads: "
+        << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / woken << " ns/wakeup"
+        << " (sum " << sum << ")" << std::endl;
+    return 0;
+}
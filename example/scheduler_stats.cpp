@@ -0,0 +1,66 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <lutask/Fiber.h>
+#include <lutask/ThreadPool.h>
+
+static void print(char const* name, lutask::SchedulerStats const& stats)
+{
+    std::cout << name
+        << " switches=" << stats.Switches
+        << " spawns=" << stats.Spawns
+        << " terminations=" << stats.Terminations
+        << " steals=" << stats.Steals
+        << " migrations=" << stats.Migrations
+        << " wakeups=" << stats.Wakeups
+        << " idle_ms=" << stats.IdleNs / 1000000
+        << " busy_ms=" << stats.BusyNs / 1000000
+        << " fibers=" << stats.Fibers
+        << " sleeping=" << stats.Sleeping << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t count = 10000;
+    std::size_t threads = 4;
+    if (argc > 1)
+    {
+        count = std::strtoul(argv[1], nullptr, 10);
+    }
+
+    // the main thread's own dispatcher
+    for (int i = 0; i < 100; ++i)
+    {
+        lutask::Fiber([]()
+        {
+            lutask::this_fiber::Yield();
+            lutask::this_fiber::sleep_for(std::chrono::microseconds(100));
+        }).Join();
+    }
+    print("main", lutask::Fiber::GetSchedulerStats());
+
+    lutask::ThreadPool pool(threads);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        pool.Post([]()
+        {
+            // a nested fiber gives the other workers something to steal, a thief
+            // sends it back home
+            lutask::Fiber(lutask::ELaunch::Async, []() { lutask::this_fiber::YieldOrigin(); }).Join();
+        });
+    }
+
+    // sampled while the pool runs, as a metrics exporter would
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    print("pool, running", pool.GetStats());
+
+    pool.Shutdown();
+    for (std::size_t i = 0; i < pool.Size(); ++i)
+    {
+        std::cout << "  worker " << i << ":";
+        print("", pool.GetStats(i));
+    }
+    print("pool, total", pool.GetStats());
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <lutask/Fiber.h>
+#include <lutask/Scheduler.h>
+
+using Clock = std::chrono::steady_clock;
+
+static std::chrono::nanoseconds total_late{ 0 };
+static std::chrono::nanoseconds max_late{ 0 };
+// woken before the deadline, must stay 0
+static std::size_t early = 0;
+
+void sleeper(std::chrono::microseconds duration)
+{
+    auto deadline = Clock::now() + duration;
+    lutask::this_fiber::sleep_until(deadline);
+    auto late = Clock::now() - deadline;
+    if (late < Clock::duration::zero())
+    {
+        ++early;
+    }
+    total_late += late;
+    max_late = (std::max)(max_late, std::chrono::duration_cast<std::chrono::nanoseconds>(late));
+}
+
+void run(char const* name, lutask::ESleepQueue mode, std::size_t fiber_total)
+{
+    lutask::Fiber::SetSleepQueue(mode);
+    total_late = max_late = std::chrono::nanoseconds{ 0 };
+    early = 0;
+
+    std::minstd_rand rng{ 42 };
+    std::uniform_int_distribution<int> distribution{ 1000, 200000 };
+
+    auto start = Clock::now();
+    std::vector<lutask::Fiber> fibers;
+    fibers.reserve(fiber_total);
+    for (std::size_t i = 0; i < fiber_total; ++i)
+    {
+        fibers.emplace_back(sleeper, std::chrono::microseconds(distribution(rng)));
+    }
+    for (lutask::Fiber& f : fibers)
+    {
+        f.Join();
+    }
+    auto elapsed = Clock::now() - start;
+
+    std::cout << name
+        << ": " << fiber_total << " timers in "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << " ms"
+        << ", mean late " << total_late.count() / fiber_total / 1000 << " us"
+        << ", max late " << max_late.count() / 1000 << " us"
+        << ", early " << early << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t fiber_total = 100000;
+    if (argc > 1)
+    {
+        fiber_total = std::strtoul(argv[1], nullptr, 10);
+    }
+
+    run("TimerWheel", lutask::ESleepQueue::TimerWheel, fiber_total);
+    run("OrderedSet", lutask::ESleepQueue::OrderedSet, fiber_total);
+    return 0;
+}
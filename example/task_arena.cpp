@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <lutask/Fiber.h>
+#include <lutask/TaskArena.h>
+#include <lutask/future/Async.h>
+#include <lutask/schedule/SharedWorkPolicy.h>
+
+// counts every trip to the global heap
+static std::atomic_size_t allocations{ 0 };
+
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+using Clock = std::chrono::steady_clock;
+
+int square(int n)
+{
+    return n * n;
+}
+
+struct Result
+{
+    char const* name;
+    Clock::duration best = Clock::duration::max();
+    std::size_t allocations = 0;
+    long long sum = 0;
+};
+
+template<typename Launch>
+void measure(Result& result, std::size_t count, Launch launch)
+{
+    long long sum = 0;
+    std::size_t before = allocations.load();
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        sum += launch(static_cast<int>(i)).Get();
+    }
+    result.best = (std::min)(result.best, Clock::now() - start);
+    result.allocations += allocations.load() - before;
+    result.sum = sum;
+}
+
+// allocate and free of one task-sized block, in ns
+template<typename Allocate, typename Free>
+double blockCost(std::size_t count, Allocate allocate, Free free)
+{
+    static void* volatile sink = nullptr;
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        void* vp = allocate(96);
+        sink = vp;
+        free(vp, 96);
+    }
+    const auto elapsed = Clock::now() - start;
+    // read back, the stores are a use the compiler has to keep
+    if (nullptr == sink)
+    {
+        std::cerr << "no block allocated" << std::endl;
+    }
+    return std::chrono::duration<double, std::nano>(elapsed).count() / count;
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t count = 100000;
+    if (argc > 1)
+    {
+        count = std::strtoul(argv[1], nullptr, 10);
+    }
+
+    // Async fibers are handed to the shared queue
+    lutask::Fiber::SetSchedulingPolicy<lutask::schedule::SharedWorkPolicy>();
+
+    // the allocators differ by a few percent of a launch, so the variants take
+    // turns and each reports its best run; the first round only warms the
+    // free lists up and is not counted
+    const std::size_t runs = 5;
+    Result results[] = { { "std::allocator + FixedSizeStack" },
+        { "TaskArena + PooledFixedSizeStack" },
+        { "task on the fiber stack (default)" } };
+
+    lutask::Fiber([count, runs, &results]()
+    {
+        for (std::size_t run = 0; run <= runs; ++run)
+        {
+            if (1 == run)
+            {
+                for (Result& result : results)
+                {
+                    result = Result{ result.name };
+                }
+            }
+
+            measure(results[0], count, [](int n)
+            {
+                return lutask::Async(std::allocator_arg, lutask::context::FixedSizeStack(), std::allocator<void>(), square, n);
+            });
+            measure(results[1], count, [](int n)
+            {
+                return lutask::Async(std::allocator_arg, lutask::context::PooledFixedSizeStack(), lutask::TaskAllocator<void>(), square, n);
+            });
+            measure(results[2], count, [](int n)
+            {
+                return lutask::Async(square, n);
+            });
+        }
+    }).Join();
+
+    for (Result const& result : results)
+    {
+        std::cout << result.name
+            << ": " << std::chrono::duration_cast<std::chrono::nanoseconds>(result.best).count() / count << " ns/call"
+            << ", " << static_cast<double>(result.allocations) / (runs * count) << " heap allocations/call"
+            << " (sum " << result.sum << ")" << std::endl;
+    }
+
+    // a launch is mostly fiber work, the allocator's share shows on its own
+    std::cout << "allocate + free of a 96 byte block: malloc "
+        << blockCost(10 * count, std::malloc, [](void* vp, std::size_t) { std::free(vp); }) << " ns, TaskArena "
+        << blockCost(10 * count, lutask::TaskArena::Allocate, lutask::TaskArena::Deallocate) << " ns" << std::endl;
+
+    lutask::TaskArenaStats stats = lutask::TaskArena::Stats();
+    std::cout << "arena hits: " << stats.Hits
+        << " misses: " << stats.Misses
+        << " slabs: " << stats.Slabs
+        << " cached: " << stats.Cached << std::endl;
+
+    lutask::context::StackPoolStats stacks = lutask::context::StackPool::Stats();
+    std::cout << "stack pool hits: " << stacks.Hits
+        << " misses: " << stacks.Misses << std::endl;
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include <lutask/Fiber.h>
+#include <lutask/ThreadPool.h>
+#include <lutask/schedule/SharedWorkPolicy.h>
+
+using Clock = std::chrono::steady_clock;
+
+template<typename Fn>
+void report(char const* name, std::size_t count, Fn fn)
+{
+    auto start = Clock::now();
+    long long sum = fn();
+    auto elapsed = Clock::now() - start;
+    std::cout << name << ": " << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / count
+        << " ns/task (sum " << sum << ")" << std::endl;
+}
+
+// two pools at work side by side: the fibers each one spawns are stealable,
+// yet they must only ever run on that pool's own workers
+bool pools_isolated(std::size_t threads)
+{
+    struct Seen
+    {
+        std::mutex mtx;
+        std::set<std::thread::id> ids;
+    };
+    Seen seen[2];
+    {
+        lutask::ThreadPool pools[2]{ lutask::ThreadPool(threads), lutask::ThreadPool(threads) };
+        for (std::size_t i = 0; i < 1000; ++i)
+        {
+            for (std::size_t p = 0; p < 2; ++p)
+            {
+                Seen* s = &seen[p];
+                pools[p].Post([s]()
+                {
+                    for (std::size_t j = 0; j < 4; ++j)
+                    {
+                        lutask::Fiber(lutask::ELaunch::Async, [s]()
+                        {
+                            for (std::size_t k = 0; k < 4; ++k)
+                            {
+                                {
+                                    std::unique_lock<std::mutex> lk(s->mtx);
+                                    s->ids.insert(std::this_thread::get_id());
+                                }
+                                lutask::this_fiber::Yield();
+                            }
+                        }).Detach();
+                    }
+                });
+            }
+        }
+    }
+
+    for (std::thread::id id : seen[0].ids)
+    {
+        if (seen[1].ids.count(id) != 0)
+            return false;
+    }
+    return seen[0].ids.size() <= threads && seen[1].ids.size() <= threads;
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t count = 1000000;
+    std::size_t threads = std::thread::hardware_concurrency();
+    if (argc > 1)
+    {
+        count = std::strtoul(argv[1], nullptr, 10);
+    }
+    if (argc > 2)
+    {
+        threads = std::strtoul(argv[2], nullptr, 10);
+    }
+
+    report("Post from the main thread", count, [count, threads]()
+    {
+        std::atomic<long long> sum{ 0 };
+        {
+            lutask::ThreadPool pool(threads);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                pool.Post([&sum](std::size_t n) { sum.fetch_add(n, std::memory_order_relaxed); }, i);
+            }
+            // the destructor drains
+        }
+        return sum.load();
+    });
+
+    report("Post from pool fibers", count, [count, threads]()
+    {
+        std::atomic<long long> sum{ 0 };
+        lutask::ThreadPool pool(threads);
+        const std::size_t batch = 1000;
+        for (std::size_t i = 0; i < count; i += batch)
+        {
+            pool.Post([&pool, &sum, i, batch, count]()
+            {
+                for (std::size_t j = i; j < i + batch && j < count; ++j)
+                {
+                    pool.Post([&sum, j]() { sum.fetch_add(j, std::memory_order_relaxed); });
+                }
+            });
+        }
+        pool.Shutdown();
+        return sum.load();
+    });
+
+    report("Async round trips", count / 10, [count, threads]()
+    {
+        lutask::ThreadPool pool(threads, []() { return new lutask::schedule::SharedWorkPolicy(); });
+        std::vector<lutask::Future<long long>> futures;
+        futures.reserve(count / 10);
+        for (std::size_t i = 0; i < count / 10; ++i)
+        {
+            futures.push_back(pool.Async([](long long n) { return n * 2; }, static_cast<long long>(i)));
+        }
+        long long sum = 0;
+        for (lutask::Future<long long>& f : futures)
+        {
+            sum += f.Get();
+        }
+        return sum;
+    });
+
+    lutask::ThreadPool pool(threads, lutask::ThreadPool::DefaultPolicy(), true);
+    bool rejected = false;
+    pool.Shutdown();
+    try
+    {
+        pool.Post([]() {});
+    }
+    catch (lutask::FiberError const&)
+    {
+        rejected = true;
+    }
+    std::cout << "Post after Shutdown rejected: " << rejected << std::endl;
+
+    const bool isolated = pools_isolated((std::max)(threads / 2, static_cast<std::size_t>(2)));
+    std::cout << "Pools never run each other's fibers: " << isolated << std::endl;
+    return isolated ? 0 : 1;
+}
@@ -0,0 +1,40 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <lutask/Fiber.h>
+#include <lutask/ThreadPool.h>
+#include <lutask/Trace.h>
+
+// configure with -DLUTASK_TRACE=ON, then open the file in chrome://tracing or ui.perfetto.dev
+int main(int argc, char* argv[])
+{
+    char const* path = argc > 1 ? argv[1] : "lutask_trace.json";
+    if (lutask::Trace::IsCompiledIn() == false)
+    {
+        std::cout << "built without LUTASK_TRACE, nothing is recorded" << std::endl;
+        return 0;
+    }
+
+    lutask::Trace::Start();
+    {
+        lutask::ThreadPool pool(2);
+        for (int i = 0; i < 20; ++i)
+        {
+            pool.Post([]()
+            {
+                lutask::this_fiber::Yield();
+                lutask::this_fiber::sleep_for(std::chrono::milliseconds(1));
+                lutask::Fiber(lutask::ELaunch::Async, []() { lutask::this_fiber::YieldOrigin(); }).Join();
+            });
+        }
+    }
+    lutask::Trace::Stop();
+
+    std::size_t count = 0;
+    {
+        std::ofstream out(path);
+        count = lutask::Trace::WriteChromeJson(out);
+    }
+    std::cout << count << " events written to " << path << std::endl;
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <lutask/Fiber.h>
+#include <lutask/schedule/WorkStealingPolicy.h>
+
+static constexpr std::size_t fiber_total = 10000;
+static constexpr std::size_t thread_total = 4;
+
+static std::atomic_size_t fiber_count{ fiber_total };
+static std::mutex mtx_finished{};
+static std::map<std::thread::id, std::size_t> finished_on{};
+
+void work(std::size_t n)
+{
+    for (std::size_t i = 0; i < n % 8; ++i)
+    {
+        lutask::this_fiber::Yield();
+    }
+
+    {
+        std::unique_lock<std::mutex> lk(mtx_finished);
+        ++finished_on[std::this_thread::get_id()];
+    }
+    fiber_count.fetch_sub(1);
+}
+
+void wait_all()
+{
+    while (0 != fiber_count.load())
+    {
+        lutask::this_fiber::Yield();
+    }
+}
+
+void Thread()
+{
+    lutask::Fiber::SetSchedulingPolicy<lutask::schedule::WorkStealingPolicy>();
+    wait_all();
+}
+
+int main()
+{
+    std::cout << "main thread started " << std::this_thread::get_id() << std::endl;
+    lutask::Fiber::SetSchedulingPolicy<lutask::schedule::WorkStealingPolicy>();
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < thread_total; ++i)
+    {
+        threads.emplace_back(Thread);
+    }
+
+    // every fiber lands on the main thread's deque, the others steal
+    for (std::size_t i = 0; i < fiber_total; ++i)
+    {
+        lutask::Fiber(lutask::ELaunch::Async, work, i).Detach();
+    }
+
+    wait_all();
+
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+
+    for (auto const& [id, count] : finished_on)
+    {
+        std::cout << "thread " << id << " finished " << count << " fibers" << std::endl;
+    }
+    return 0;
+}
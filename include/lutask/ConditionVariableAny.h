@@ -3,6 +3,7 @@
 #include <cassert>
 #include <mutex>
 #include <lutask/WaitQueue.h>
+#include <lutask/detail/Spinlock.h>
 #include <lutask/Context.h>
 
 namespace lutask
@@ -10,7 +11,7 @@ namespace lutask
 class ConditionVariableAny
 {
 private:
-    std::mutex  m_;
+    detail::Spinlock m_;
 	WaitQueue	waitQueue_;
 
 public:
@@ -22,13 +23,13 @@ public:
 
     void NotifyOne() noexcept
     {
-        std::unique_lock<std::mutex> lock(m_);
+        std::unique_lock<detail::Spinlock> lock(m_);
         waitQueue_.NotifyOne();
     }
 
     void NotifyAll() noexcept
     {
-        std::unique_lock<std::mutex> lock(m_);
+        std::unique_lock<detail::Spinlock> lock(m_);
         waitQueue_.NotifyAll();
     }
 
@@ -36,7 +37,7 @@ public:
     void Wait(LockType& lt) 
     {
         Context* active_ctx = Context::Active();
-        std::unique_lock<std::mutex> lk(m_);
+        std::unique_lock<detail::Spinlock> lk(m_);
 
         lt.unlock();
         waitQueue_.SuspendAndWait(lk, active_ctx);
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <tuple>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <chrono>
 
 #include <lutask/Preallocated.h>
@@ -10,12 +13,18 @@
 #include <lutask/WaitQueue.h>
 #include <lutask/context/FiberContext.h>
 #include <lutask/smart_ptr/intrusive_ptr.h>
+#include <lutask/detail/IntrusiveList.h>
+#include <lutask/detail/Spinlock.h>
+#include <lutask/TimerWheel.h>
+#include <lutask/Trace.h>
 
 namespace lutask
 {
     namespace schedule
     {
         class IPolicy;
+        class PriorityPolicy;
+        class EdfPolicy;
     }
 
     enum class EType
@@ -34,7 +43,35 @@ namespace lutask
 
     class Scheduler;
     class Fiber;
-    struct Context
+
+    // hook tag of Scheduler's worker list
+    struct WorkerHookTag {};
+    // hook tag of the ready queues of policies that link contexts directly
+    struct ReadyHookTag {};
+
+    // bands of PriorityPolicy, higher runs first; other policies ignore it
+    enum class EPriority : std::uint8_t
+    {
+        Low,
+        Normal,
+        High,
+        Critical
+    };
+
+    // a timed wait ends either by a notify or by its deadline, whichever
+    // claims it first makes the context ready
+    enum class EWait : std::uint32_t
+    {
+        None,
+        Timed,
+        Notified,
+        Expired
+    };
+
+    struct Context : public detail::ListHook<WorkerHookTag>
+                   , public detail::ListHook<SleepHookTag>
+                   , public detail::ListHook<WaitHookTag>
+                   , public detail::ListHook<ReadyHookTag>
     {
         friend class Fiber;
         using TimePoint = std::chrono::steady_clock::time_point;
@@ -43,9 +80,13 @@ namespace lutask
 
     private:
         friend class Scheduler;
+        friend class TimerWheel;
+        friend class WaitQueue;
         friend struct DispatcherContext;
         friend struct MainContext;
         friend struct ContextDeleter;
+        friend class schedule::PriorityPolicy;
+        friend class schedule::EdfPolicy;
         template< typename Fn, typename ... Arg >
         friend struct WorkerContext;
 
@@ -55,16 +96,39 @@ namespace lutask
         Scheduler* originScheduler_;
         context::FiberContext c_;
         WaitQueue waitList_;
+        // guards waitList_ against terminated_, joiners and the dying fiber may run on different threads
+        detail::Spinlock splk_;
         TimePoint tp_;
+        std::uint32_t timerSlot_{ 0 };
+        // where the policy queued the context, meaning is up to the policy
+        std::uint32_t readySlot_{ 0 };
+        std::atomic<EPriority> priority_{ EPriority::Normal };
+        // absolute deadline for EdfPolicy, max() for none
+        std::atomic<TimePoint> deadline_{ (TimePoint::max)() };
+        Context* remoteNext_{ nullptr };
+        // steady clock ns of the last Schedule() while latency is measured, 0 otherwise
+        std::uint64_t readySince_{ 0 };
+        std::atomic<EWait> wait_{ EWait::None };
         EType type_;
         ELaunch policy_;
         bool terminated_{ false };
+#if defined(LUTASK_TRACE)
+        // names the context in a trace, addresses are reused by the next fiber
+        std::uint64_t traceId_{ Trace::NextId() };
+#endif
 
         Context(std::size_t initialCount, EType type, ELaunch policy) noexcept;
 
+        bool ClaimWakeup(EWait by) noexcept;
+
+        template<typename Lock>
+        void ResumeUnlocking_(Lock& lk) noexcept;
+
     public:
         static bool InitializeThread(schedule::IPolicy* policy, context::FixedSizeStack&& salloc) noexcept;
         static Context* Active() noexcept;
+        // the active context, nullptr on a thread that never set up a scheduler
+        static Context* ActiveIfAny() noexcept;
         static void ChangeActive(Context* ctx) noexcept;
         static void ResetActive() noexcept;
 
@@ -83,21 +147,35 @@ namespace lutask
 
         void Resume() noexcept;
         void Resume(std::unique_lock<std::mutex>& lk) noexcept;
+        void Resume(std::unique_lock<detail::Spinlock>& lk) noexcept;
         void Resume(Context* ctx) noexcept;
 
         void Suspend() noexcept;
         void Suspend(std::unique_lock<std::mutex>& lk) noexcept;
+        void Suspend(std::unique_lock<detail::Spinlock>& lk) noexcept;
 
         lutask::context::FiberContext SuspendWithCC() noexcept;
         lutask::context::FiberContext Terminate() noexcept;
 
         bool WaitUntil(std::chrono::steady_clock::time_point const& tp) noexcept;
+        bool WaitUntil(std::chrono::steady_clock::time_point const& tp, std::unique_lock<std::mutex>& lk) noexcept;
+        bool WaitUntil(std::chrono::steady_clock::time_point const& tp, std::unique_lock<detail::Spinlock>& lk) noexcept;
         bool Wake() noexcept;
 
         bool IsResumable() const noexcept { return static_cast<bool>(c_); }
 
         bool IsContext(EType t) const noexcept { return EType::None != (type_ & t); }
         ELaunch GetType() const noexcept { return policy_; }
+#if defined(LUTASK_TRACE)
+        std::uint64_t GetTraceId() const noexcept { return traceId_; }
+#endif
+        EPriority GetPriority() const noexcept { return priority_.load(std::memory_order_relaxed); }
+        // requeues a ready context when called on its own thread, from another
+        // thread the new priority applies from the next wake
+        void SetPriority(EPriority priority) noexcept;
+        TimePoint GetDeadline() const noexcept { return deadline_.load(std::memory_order_relaxed); }
+        // same rules as SetPriority()
+        void SetDeadline(TimePoint const& deadline) noexcept;
         Scheduler* GetScheduler() const noexcept { return scheduler_; }
         void SetScheduler(Scheduler* sche) noexcept { scheduler_ = sche; }
 
@@ -133,10 +211,14 @@ namespace lutask
 
         lutask::context::FiberContext Run_(lutask::context::FiberContext&& /*c*/)
         {
-            auto fn = std::move(fn_);
-            auto args = std::move(args_);
+            {
+                // the callable and its arguments die with the fiber, not with
+                // the context, so whatever they own is released right away
+                auto fn = std::move(fn_);
+                auto args = std::move(args_);
 
-            std::apply(std::move(fn), std::move(args));
+                std::apply(std::move(fn), std::move(args));
+            }
 
             return Terminate();
         }
@@ -154,14 +236,16 @@ namespace lutask
         }
     };
 
+    // builds the context below top on a stack the caller allocated already,
+    // whatever lies between top and sctx.Sp is left to the caller
     template<typename StackAlloc, typename Fn, typename ...Args>
-    static Context::Ptr MakeWorkerContext(ELaunch policy, StackAlloc&& salloc, Fn&& fn, Args ... args)
+    static Context::Ptr PlaceWorkerContext(ELaunch policy, context::StackContext const& sctx, void* top,
+        StackAlloc&& salloc, Fn&& fn, Args ... args)
     {
         typedef WorkerContext< Fn, Args ... >   ContextType;
 
-        auto sctx = salloc.Allocate();
         void* storage = reinterpret_cast<void*>(
-            (reinterpret_cast<uintptr_t>(sctx.Sp) - static_cast<uintptr_t>(sizeof(ContextType)))
+            (reinterpret_cast<uintptr_t>(top) - static_cast<uintptr_t>(sizeof(ContextType)))
             & ~static_cast<uintptr_t>(0xff));
         void* stack_bottom = reinterpret_cast<void*>(
             reinterpret_cast<uintptr_t>(sctx.Sp) - static_cast<uintptr_t>(sctx.Size));
@@ -172,4 +256,12 @@ namespace lutask
             Preallocated(storage, size, sctx), std::forward<StackAlloc>(salloc),
             std::forward<Fn>(fn), std::forward<Args>(args)...));
     }
+
+    template<typename StackAlloc, typename Fn, typename ...Args>
+    static Context::Ptr MakeWorkerContext(ELaunch policy, StackAlloc&& salloc, Fn&& fn, Args ... args)
+    {
+        auto sctx = salloc.Allocate();
+        return PlaceWorkerContext(policy, sctx, sctx.Sp, std::forward<StackAlloc>(salloc),
+            std::forward<Fn>(fn), std::forward<Args>(args)...);
+    }
 }
\ No newline at end of file
@@ -17,11 +17,19 @@ public:
     ~FiberError() override = default;
 };
 
+class LockError : public FiberError
+{
+public:
+    explicit LockError(std::error_code ec) : FiberError{ ec } { }
+    LockError(std::error_code ec, const char* what_arg) : FiberError{ ec, what_arg } { }
+};
+
 enum class ETaskError
 {
     AlreadyRetrived,
     AlreadySatisfied,
-    NoState
+    NoState,
+    BrokenPromise
 };
 
 std::error_category const& TaskCategory() noexcept;
@@ -66,4 +74,16 @@ public:
     PackagedTaskUninitialized() : TaskError{ std::make_error_code(ETaskError::NoState) } { }
 };
 
+class PromiseUninitialized : public TaskError
+{
+public:
+    PromiseUninitialized() : TaskError{ std::make_error_code(ETaskError::NoState) } { }
+};
+
+class BrokenPromise : public TaskError
+{
+public:
+    BrokenPromise() : TaskError{ std::make_error_code(ETaskError::BrokenPromise) } { }
+};
+
 }
\ No newline at end of file
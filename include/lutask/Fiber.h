@@ -1,10 +1,17 @@
 #pragma once
 
+#include <exception>
+#include <type_traits>
 #include <lutask/Context.h>
+#include <lutask/context/PooledFixedSizeStack.h>
 #include <lutask/LaunchPolicy.h>
+#include <lutask/LatencyHistogram.h>
+#include <lutask/SchedulerStats.h>
 
 namespace lutask
 {
+enum class ESleepQueue;
+
 class Fiber final
 {
 private:
@@ -13,8 +20,44 @@ private:
 	Context::Ptr impl_;
 
 	void _Start() noexcept;
+	static void _StartBatch(ELaunch launch, Context::Ptr* batch, std::size_t count) noexcept;
+
+	template<typename StackAllocator, typename It, typename Fn, typename Arg>
+	static void _Spawn(ELaunch launch, StackAllocator const& salloc, It first, It last, Fn& fn, Arg const& arg)
+	{
+		Context::Ptr batch[MaxBatch];
+		std::size_t count = 0;
+		std::exception_ptr error;
+		try
+		{
+			for (; first != last; ++first)
+			{
+				batch[count++] = MakeWorkerContext(launch, StackAllocator(salloc), fn, arg(first));
+				if (MaxBatch == count)
+				{
+					_StartBatch(launch, batch, count);
+					count = 0;
+				}
+			}
+		}
+		catch (...)
+		{
+			// started outside the handler: a dispatch launch yields, and the
+			// fibers running meanwhile must not see our exception as caught
+			error = std::current_exception();
+		}
+		// what was built so far runs, as it would with a loop of Fiber()
+		_StartBatch(launch, batch, count);
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}
+	}
 
 public:
+	// fibers a batch launch builds before handing them to the scheduler
+	static constexpr std::size_t MaxBatch = 64;
+
 	template<typename Fn, typename ...Args>
 	explicit Fiber(Fn&& fn, Args&& ...args)
 		: Fiber( ELaunch::Post, std::allocator_arg, context::FixedSizeStack(), std::forward<Fn>(fn), std::forward<Args>(args)...)
@@ -28,8 +71,46 @@ public:
 
 	template<typename StackAllocator, typename Fn, typename ...Args>
 	explicit Fiber(ELaunch launch, std::allocator_arg_t, StackAllocator&& salloc, Fn&& fn, Args&& ...args)
+		: Fiber(launch, EPriority::Normal, std::allocator_arg, std::forward<StackAllocator>(salloc), std::forward<Fn>(fn), std::forward<Args>(args)...)
+	{}
+
+	template<typename Fn, typename ...Args>
+	explicit Fiber(EPriority priority, Fn&& fn, Args&& ...args)
+		: Fiber(ELaunch::Post, priority, std::allocator_arg, context::FixedSizeStack(), std::forward<Fn>(fn), std::forward<Args>(args)...)
+	{}
+
+	template<typename Fn, typename ...Args>
+	explicit Fiber(ELaunch launch, EPriority priority, Fn&& fn, Args&& ...args)
+		: Fiber(launch, priority, std::allocator_arg, context::FixedSizeStack(), std::forward<Fn>(fn), std::forward<Args>(args)...)
+	{}
+
+	// the priority is set before the fiber is scheduled for the first time
+	template<typename StackAllocator, typename Fn, typename ...Args>
+	explicit Fiber(ELaunch launch, EPriority priority, std::allocator_arg_t, StackAllocator&& salloc, Fn&& fn, Args&& ...args)
 	{
 		impl_ = MakeWorkerContext(launch, std::forward<StackAllocator>(salloc), std::forward<Fn>(fn), std::forward<Args>(args)...);
+		impl_->priority_.store(priority, std::memory_order_relaxed);
+		_Start();
+	}
+
+	template<typename Fn, typename ...Args>
+	explicit Fiber(Context::TimePoint deadline, Fn&& fn, Args&& ...args)
+		: Fiber(ELaunch::Post, deadline, std::allocator_arg, context::FixedSizeStack(), std::forward<Fn>(fn), std::forward<Args>(args)...)
+	{}
+
+	// the deadline is set before the fiber is scheduled for the first time
+	template<typename StackAllocator, typename Fn, typename ...Args>
+	explicit Fiber(ELaunch launch, Context::TimePoint deadline, std::allocator_arg_t, StackAllocator&& salloc, Fn&& fn, Args&& ...args)
+	{
+		impl_ = MakeWorkerContext(launch, std::forward<StackAllocator>(salloc), std::forward<Fn>(fn), std::forward<Args>(args)...);
+		impl_->deadline_.store(deadline, std::memory_order_relaxed);
+		_Start();
+	}
+
+	// starts a context that was built by the caller
+	explicit Fiber(Context::Ptr&& impl)
+		: impl_(std::move(impl))
+	{
 		_Start();
 	}
 
@@ -67,12 +148,59 @@ public:
 	void Join();
 	void Detach();
 
+	EPriority GetPriority() const noexcept { return impl_->GetPriority(); }
+	void SetPriority(EPriority priority) noexcept { impl_->SetPriority(priority); }
+
+	Context::TimePoint GetDeadline() const noexcept { return impl_->GetDeadline(); }
+	void SetDeadline(Context::TimePoint const& deadline) noexcept { impl_->SetDeadline(deadline); }
+
 public:
 	template<typename Policy, typename ... Args>
 	static void SetSchedulingPolicy(Args && ... args) noexcept 
 	{
 		Context::InitializeThread(new Policy(std::forward<Args>(args)...), lutask::context::FixedSizeStack());
 	}
+
+	static void SetSleepQueue(ESleepQueue mode,
+		std::chrono::steady_clock::duration tick = std::chrono::milliseconds(1)) noexcept;
+
+	// counters of the calling thread's scheduler, Scheduler::GetStats() reads
+	// those of another thread
+	static SchedulerStats GetSchedulerStats() noexcept;
+	// latency histograms of the calling thread's scheduler
+	static void EnableLatencyHistograms();
+	static SchedulerLatency GetSchedulerLatency() noexcept;
+
+	// Launches fn(i) for every i in [first, last) as detached fibers. Up to
+	// MaxBatch contexts at a time are attached under one lock and handed to
+	// the policy in one call, which wakes idle threads once per batch instead
+	// of once per fiber. ELaunch::Dispatch yields after each batch rather than
+	// switching into every fiber. Stacks come from the thread's stack pool.
+	template<typename Integer, typename Fn>
+	static void Spawn(ELaunch launch, Integer first, Integer last, Fn&& fn)
+	{
+		Spawn(launch, std::allocator_arg, context::PooledFixedSizeStack(), first, last, std::forward<Fn>(fn));
+	}
+
+	template<typename StackAllocator, typename Integer, typename Fn>
+	static void Spawn(ELaunch launch, std::allocator_arg_t, StackAllocator&& salloc, Integer first, Integer last, Fn&& fn)
+	{
+		static_assert(std::is_integral<Integer>::value, "lutask: Spawn() takes an index range, SpawnEach() iterators");
+		_Spawn(launch, salloc, first, last, fn, [](Integer i) { return i; });
+	}
+
+	// the same for fn(*it) of every element of [first, last), each fiber gets a copy
+	template<typename InputIt, typename Fn>
+	static void SpawnEach(ELaunch launch, InputIt first, InputIt last, Fn&& fn)
+	{
+		SpawnEach(launch, std::allocator_arg, context::PooledFixedSizeStack(), first, last, std::forward<Fn>(fn));
+	}
+
+	template<typename StackAllocator, typename InputIt, typename Fn>
+	static void SpawnEach(ELaunch launch, std::allocator_arg_t, StackAllocator&& salloc, InputIt first, InputIt last, Fn&& fn)
+	{
+		_Spawn(launch, salloc, first, last, fn, [](InputIt const& it) { return *it; });
+	}
 };
 
 namespace this_fiber
@@ -94,6 +222,12 @@ namespace this_fiber
 	inline void Yield() noexcept { lutask::Context::Active()->Yield(); }
 	inline void YieldOrigin() noexcept { lutask::Context::Active()->YieldOrigin(); }
 
+	inline EPriority GetPriority() noexcept { return lutask::Context::Active()->GetPriority(); }
+	inline void SetPriority(EPriority priority) noexcept { lutask::Context::Active()->SetPriority(priority); }
+
+	inline Context::TimePoint GetDeadline() noexcept { return lutask::Context::Active()->GetDeadline(); }
+	inline void SetDeadline(Context::TimePoint const& deadline) noexcept { lutask::Context::Active()->SetDeadline(deadline); }
+
 	template<typename Rep, typename Period>
 	void sleep_until(std::chrono::time_point<Rep, Period> const& sleepTime)
 	{
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <lutask/detail/OwnerCounter.h>
+
+namespace lutask
+{
+
+namespace detail
+{
+class AtomicHistogram;
+}
+
+// Log-linear histogram of nanosecond latencies, in the manner of HdrHistogram:
+// values below SubBuckets are counted exactly, above that every power of two
+// is split into SubBuckets linear buckets, so a bucket is never wider than
+// 1/SubBuckets of its lower bound. Values beyond 2^(MaxExponent+1) ns land in
+// the last bucket. Histograms of the same layout add up bucket by bucket.
+class LatencyHistogram
+{
+public:
+    static constexpr std::size_t SubBucketBits = 4;
+    static constexpr std::size_t SubBuckets = std::size_t(1) << SubBucketBits;
+    static constexpr std::size_t MaxExponent = 47;
+    static constexpr std::size_t BucketCount = (MaxExponent - SubBucketBits + 2) * SubBuckets;
+
+    static std::size_t BucketOf(std::uint64_t ns) noexcept;
+    static std::uint64_t LowerBound(std::size_t bucket) noexcept;
+    static std::uint64_t UpperBound(std::size_t bucket) noexcept;
+
+    void Record(std::uint64_t ns, std::uint64_t count = 1) noexcept;
+    void Reset() noexcept;
+
+    LatencyHistogram& operator+=(LatencyHistogram const& other) noexcept;
+
+    std::uint64_t Count() const noexcept { return count_; }
+    std::uint64_t Min() const noexcept { return 0 != count_ ? min_ : 0; }
+    std::uint64_t Max() const noexcept { return max_; }
+    double Mean() const noexcept { return 0 != count_ ? static_cast<double>(sum_) / count_ : 0.0; }
+    std::uint64_t Bucket(std::size_t bucket) const noexcept { return counts_[bucket]; }
+
+    // the upper bound of the bucket holding the percentile, percentile in [0, 100]
+    std::uint64_t Percentile(double percentile) const noexcept;
+
+    // {"count":..,"min_ns":..,"mean_ns":..,"p50_ns":..,"p90_ns":..,"p99_ns":..,
+    //  "p999_ns":..,"max_ns":..,"buckets":[[lower,upper,count],..]}, empty buckets left out
+    void WriteJson(std::ostream& out) const;
+
+private:
+    friend class detail::AtomicHistogram;
+
+    std::uint64_t counts_[BucketCount] = {};
+    std::uint64_t count_ = 0;
+    std::uint64_t sum_ = 0;
+    std::uint64_t min_ = ~std::uint64_t(0);
+    std::uint64_t max_ = 0;
+};
+
+namespace detail
+{
+
+// The recording side kept by a scheduler: one thread records with a plain
+// load and store per counter, Snapshot() copies it out from any thread.
+class AtomicHistogram
+{
+public:
+    void Record(std::uint64_t ns) noexcept
+    {
+        Bump(counts_[LatencyHistogram::BucketOf(ns)], 1);
+        Bump(count_, 1);
+        Bump(sum_, ns);
+        LowerTo(min_, ns);
+        RaiseTo(max_, ns);
+    }
+
+    LatencyHistogram Snapshot() const noexcept;
+
+private:
+    std::atomic<std::uint64_t> counts_[LatencyHistogram::BucketCount] = {};
+    std::atomic<std::uint64_t> count_{ 0 };
+    std::atomic<std::uint64_t> sum_{ 0 };
+    std::atomic<std::uint64_t> min_{ ~std::uint64_t(0) };
+    std::atomic<std::uint64_t> max_{ 0 };
+};
+
+}
+
+// the two histograms a scheduler keeps once enabled
+struct SchedulerLatency
+{
+    LatencyHistogram ReadyWait;   // from becoming ready to being resumed, a remote wake's time in the inbox included
+    LatencyHistogram RunSlice;    // from being resumed to switching out
+
+    SchedulerLatency& operator+=(SchedulerLatency const& other) noexcept
+    {
+        ReadyWait += other.ReadyWait;
+        RunSlice += other.RunSlice;
+        return *this;
+    }
+};
+
+}
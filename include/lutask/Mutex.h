@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <lutask/WaitQueue.h>
+#include <lutask/detail/Spinlock.h>
+
+namespace lutask
+{
+
+struct Context;
+class Scheduler;
+
+// Blocks only the contending fiber, never the thread. Lock() spins briefly for
+// an owner running on another thread, then parks the fiber in a FIFO queue;
+// Unlock() hands the mutex straight to the oldest waiter so a late locker
+// cannot overtake it. Owner and waiters may live on different threads.
+class Mutex
+{
+    friend class RecursiveMutex;
+
+public:
+    Mutex() = default;
+    ~Mutex();
+
+    Mutex(Mutex const&) = delete;
+    Mutex& operator=(Mutex const&) = delete;
+
+    void Lock();
+    bool TryLock();
+    void Unlock();
+
+    // Lockable, for std::unique_lock and ConditionVariableAny
+    void lock() { Lock(); }
+    bool try_lock() { return TryLock(); }
+    void unlock() { Unlock(); }
+
+protected:
+    static constexpr unsigned SpinCount = 6;
+
+    bool TryAcquire(Context* ctx) noexcept;
+    // tp == nullptr waits without a deadline
+    bool LockSlow(Context* ctx, std::chrono::steady_clock::time_point const* tp);
+    void Release(Context* ctx);
+
+private:
+    std::atomic<Context*>   owner_{ nullptr };
+    // where the owner took the lock, spinning for an owner on our own thread is wasted
+    std::atomic<Scheduler*> ownerScheduler_{ nullptr };
+    // fibers inside LockSlow(), Unlock() takes the fast path while it is zero
+    std::atomic_size_t      waiting_{ 0 };
+    detail::Spinlock        splk_;
+    WaitQueue               waitQueue_;
+};
+
+class TimedMutex : public Mutex
+{
+public:
+    TimedMutex() = default;
+
+    bool TryLockUntil(std::chrono::steady_clock::time_point const& tp);
+
+    template<typename Clock, typename Duration>
+    bool TryLockUntil(std::chrono::time_point<Clock, Duration> const& tp)
+    {
+        return TryLockUntil(std::chrono::steady_clock::now() + (tp - Clock::now()));
+    }
+
+    template<typename Rep, typename Period>
+    bool TryLockFor(std::chrono::duration<Rep, Period> const& timeout)
+    {
+        return TryLockUntil(std::chrono::steady_clock::now() + timeout);
+    }
+
+    // TimedLockable
+    template<typename Clock, typename Duration>
+    bool try_lock_until(std::chrono::time_point<Clock, Duration> const& tp) { return TryLockUntil(tp); }
+
+    template<typename Rep, typename Period>
+    bool try_lock_for(std::chrono::duration<Rep, Period> const& timeout) { return TryLockFor(timeout); }
+};
+
+// the owning fiber may lock it again, it is released after as many Unlock()
+class RecursiveMutex
+{
+public:
+    RecursiveMutex() = default;
+
+    RecursiveMutex(RecursiveMutex const&) = delete;
+    RecursiveMutex& operator=(RecursiveMutex const&) = delete;
+
+    void Lock();
+    bool TryLock();
+    void Unlock();
+
+    void lock() { Lock(); }
+    bool try_lock() { return TryLock(); }
+    void unlock() { Unlock(); }
+
+private:
+    Mutex       mtx_;
+    // only touched by the owner
+    std::size_t count_{ 0 };
+};
+
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <lutask/Fiber.h>
+#include <lutask/context/PooledFixedSizeStack.h>
+#include <lutask/detail/Spinlock.h>
+
+// Fork-join helpers on fibers of the calling thread's scheduler. The parts go
+// out with ELaunch::Post, so the policy decides who runs them: WorkStealing
+// and SharedWork threads take them over, RoundRobin runs them on the caller.
+// The caller waits by joining, which suspends its fiber and never blocks the
+// thread. The first exception of any part is rethrown once all parts have
+// finished, parts that had not started by then are skipped.
+
+namespace lutask
+{
+
+namespace detail
+{
+
+class ParallelError
+{
+public:
+    bool Failed() const noexcept { return failed_.load(std::memory_order_relaxed); }
+
+    void Capture() noexcept
+    {
+        std::unique_lock<Spinlock> lk(splk_);
+        if (nullptr == error_)
+        {
+            error_ = std::current_exception();
+        }
+        failed_.store(true, std::memory_order_relaxed);
+    }
+
+    void Rethrow()
+    {
+        if (nullptr != error_)
+            std::rethrow_exception(error_);
+    }
+
+private:
+    std::atomic_bool failed_{ false };
+    Spinlock splk_{};
+    std::exception_ptr error_{};
+};
+
+struct ParallelUnit {};
+
+template<typename Fn>
+Fiber SpawnPart(Fn&& fn)
+{
+    return Fiber(ELaunch::Post, std::allocator_arg, context::PooledFixedSizeStack(), std::forward<Fn>(fn));
+}
+
+// Lazy binary splitting: [begin, end) is worked off a grain at a time from
+// the front, and the back half goes to a new fiber only after the previous
+// one split off has started, that is another worker took it or nothing else
+// was left to run. Idle workers thus get the largest untouched pieces, and a
+// thread that has nobody to share with splits once per level instead of once
+// per grain. fold(b, e, acc) folds a grain into acc, combine(left, right)
+// joins the results of neighbouring pieces in range order.
+template<typename Index, typename T, typename Fold, typename Combine>
+T ParallelSplit(Index begin, Index end, Index grain, T const& identity,
+    Fold const& fold, Combine const& combine, ParallelError& error) noexcept
+{
+    // the pieces split off, each one behind the previous in the range
+    std::deque<T> results;
+    std::vector<Fiber> parts;
+    std::atomic_bool pending{ false };
+
+    T acc = identity;
+    while (begin < end && error.Failed() == false)
+    {
+        try
+        {
+            if (grain < end - begin && pending.load(std::memory_order_acquire) == false)
+            {
+                const Index mid = begin + (end - begin) / 2;
+                parts.reserve(parts.size() + 1);
+                results.emplace_back(identity);
+                T* result = &results.back();
+                pending.store(true, std::memory_order_relaxed);
+                parts.push_back(SpawnPart([mid, end, grain, &identity, &fold, &combine, &error, &pending, result]()
+                {
+                    pending.store(false, std::memory_order_release);
+                    *result = ParallelSplit(mid, end, grain, identity, fold, combine, error);
+                }));
+                end = mid;
+                continue;
+            }
+
+            const Index next = grain < end - begin ? begin + grain : end;
+            acc = fold(begin, next, std::move(acc));
+            begin = next;
+        }
+        catch (...)
+        {
+            error.Capture();
+        }
+    }
+
+    for (Fiber& part : parts)
+    {
+        part.Join();
+    }
+
+    try
+    {
+        for (auto it = results.rbegin(); it != results.rend() && error.Failed() == false; ++it)
+        {
+            acc = combine(std::move(acc), std::move(*it));
+        }
+    }
+    catch (...)
+    {
+        error.Capture();
+    }
+    return acc;
+}
+
+}
+
+// fn(i) for every i in [begin, end), grain is the smallest piece worth a fiber
+template<typename Index, typename Fn>
+void ParallelFor(Index begin, Index end, Index grain, Fn&& fn)
+{
+    static_assert(std::is_integral<Index>::value, "lutask: ParallelFor() takes an index range");
+
+    detail::ParallelError error;
+    detail::ParallelSplit(begin, end, (std::max)(grain, Index(1)), detail::ParallelUnit{},
+        [&fn](Index b, Index e, detail::ParallelUnit unit)
+        {
+            for (; b != e; ++b)
+            {
+                fn(b);
+            }
+            return unit;
+        },
+        [](detail::ParallelUnit unit, detail::ParallelUnit) { return unit; },
+        error);
+    error.Rethrow();
+}
+
+// reduce over map(i) of every i in [begin, end), starting from identity;
+// reduce has to be associative, the operands keep their range order
+template<typename Index, typename T, typename Map, typename Reduce>
+T ParallelReduce(Index begin, Index end, Index grain, T identity, Map&& map, Reduce&& reduce)
+{
+    static_assert(std::is_integral<Index>::value, "lutask: ParallelReduce() takes an index range");
+
+    detail::ParallelError error;
+    T result = detail::ParallelSplit(begin, end, (std::max)(grain, Index(1)), identity,
+        [&map, &reduce](Index b, Index e, T acc)
+        {
+            for (; b != e; ++b)
+            {
+                acc = reduce(std::move(acc), map(b));
+            }
+            return acc;
+        },
+        reduce, error);
+    error.Rethrow();
+    return result;
+}
+
+// out[i] = fn(first[i]) for the elements of [first, last), returns the end of the output
+template<typename RandomIt, typename OutputIt, typename Fn>
+OutputIt ParallelTransform(RandomIt first, RandomIt last, OutputIt out, std::size_t grain, Fn&& fn)
+{
+    static_assert(std::is_base_of<std::random_access_iterator_tag,
+        typename std::iterator_traits<RandomIt>::iterator_category>::value, "lutask: ParallelTransform() needs random access");
+    static_assert(std::is_base_of<std::random_access_iterator_tag,
+        typename std::iterator_traits<OutputIt>::iterator_category>::value, "lutask: ParallelTransform() needs random access");
+
+    const std::size_t count = static_cast<std::size_t>(std::distance(first, last));
+    ParallelFor(std::size_t(0), count, grain, [first, out, &fn](std::size_t i)
+    {
+        out[i] = fn(first[i]);
+    });
+    return out + count;
+}
+
+// every fn in a fiber of its own, returns once all have finished
+template<typename ...Fns>
+void ParallelInvoke(Fns&& ...fns)
+{
+    detail::ParallelError error;
+    std::vector<Fiber> parts;
+    auto joinAll = [&parts]()
+    {
+        for (Fiber& part : parts)
+        {
+            part.Join();
+        }
+    };
+
+    try
+    {
+        parts.reserve(sizeof...(Fns));
+        (parts.push_back(detail::SpawnPart([&error, &fns]()
+        {
+            if (error.Failed())
+                return;
+
+            try
+            {
+                fns();
+            }
+            catch (...)
+            {
+                error.Capture();
+            }
+        })), ...);
+    }
+    catch (...)
+    {
+        joinAll();
+        throw;
+    }
+    joinAll();
+    error.Rethrow();
+}
+
+}
@@ -1,17 +1,26 @@
 #pragma once
 
 #include <queue>
-#include <list>
 #include <set>
-#include <concurrent_unordered_map.h>
-#include <concurrent_queue.h>
+#include <mutex>
+#include <atomic>
 
 #include <lutask/Context.h>
+#include <lutask/LatencyHistogram.h>
+#include <lutask/SchedulerStats.h>
+#include <lutask/detail/OwnerCounter.h>
 #include <lutask/schedule/IPolicy.h>
+#include <lutask/detail/MPMCQueue.h>
 
 namespace lutask
 {
 
+enum class ESleepQueue
+{
+	TimerWheel,
+	OrderedSet
+};
+
 class Scheduler
 {
 	struct TimepointLess
@@ -23,19 +32,68 @@ class Scheduler
 	};
 
 private:
+	// numbers schedulers in the order they were made, starting at 1
+	static std::atomic_uint32_t nextId_;
+	std::uint32_t	id_;
 	Context*		mainContext_;
 	Context::Ptr	dispatcherContext_;
 	lutask::schedule::IPolicy*	policy_;
 	bool				shutdown_{ false };
 
-	std::list<Context*> workerQueue_;
-	concurrency::concurrent_queue<Context*> terminatedQueue_;
+	detail::IntrusiveList<Context, WorkerHookTag> workerQueue_;
+	std::atomic_size_t	workerCount_{ 0 };
+	detail::MPMCQueue<Context*> terminatedQueue_;
+	ESleepQueue		sleepMode_{ ESleepQueue::TimerWheel };
+	TimerWheel		timerWheel_{};
 	std::multiset<Context*, TimepointLess> sleepQueue_;
 	std::mutex mtx_;
 
+	// Written by the owning thread alone with a plain load and store, read by
+	// GetStats() from anywhere. The line of their own keeps the owner's
+	// writes from bouncing a line other threads touch.
+	struct alignas(detail::CacheLineSize) Counters
+	{
+		std::atomic<std::uint64_t> switches{ 0 };
+		std::atomic<std::uint64_t> spawns{ 0 };
+		std::atomic<std::uint64_t> terminations{ 0 };
+		std::atomic<std::uint64_t> steals{ 0 };
+		std::atomic<std::uint64_t> migrations{ 0 };
+		std::atomic<std::uint64_t> wakeups{ 0 };
+		std::atomic<std::uint64_t> idleNs{ 0 };
+		std::atomic<std::uint64_t> busyNs{ 0 };
+		std::atomic<std::uint64_t> sleeping{ 0 };
+		// start of the current busy or idle stretch, 0 while in the other one
+		std::atomic<std::uint64_t> busySince{ 0 };
+		std::atomic<std::uint64_t> idleSince{ 0 };
+	};
+	Counters counters_;
+
+	struct alignas(detail::CacheLineSize) Latency
+	{
+		detail::AtomicHistogram readyWait;
+		detail::AtomicHistogram runSlice;
+	};
+	// installed once by EnableLatencyHistograms(), null keeps the switch path untimed
+	std::atomic<Latency*> latency_{ nullptr };
+	// when the running context was resumed
+	std::uint64_t sliceStart_{ 0 };
+
+	// contexts woken from other threads, a lock-free stack drained by Dispatch()
+	alignas(detail::CacheLineSize) std::atomic<Context*> remoteHead_{ nullptr };
+
 private:
 	void ProcTerminated();
+	void ProcRemoteReady() noexcept;
 	void ProcSleepToReady();
+	void Sleep(Context* ctx, std::chrono::steady_clock::time_point const& tp) noexcept;
+	void CancelSleep(Context* ctx) noexcept;
+	// Schedule() without the trace event and ready stamp
+	void Awaken(Context* ctx) noexcept;
+	std::chrono::steady_clock::time_point NextSleepDeadline() noexcept;
+	// PickNext() of the policy for a context that is about to be switched out
+	Context* PickNextSwitch() noexcept;
+	void StampReady(Context* ctx) noexcept;
+	void TimeSwitch(Context* from, Context* to) noexcept;
 
 public:
 	Scheduler(lutask::schedule::IPolicy* policy) noexcept;
@@ -44,10 +102,42 @@ public:
 
 	virtual ~Scheduler();
 
-	void Schedule(Context* ctx) noexcept;
+	// may only be switched while no fiber of this scheduler is sleeping
+	void SetSleepQueue(ESleepQueue mode,
+		std::chrono::steady_clock::duration tick = std::chrono::milliseconds(1)) noexcept;
+	std::size_t GetSleepCount() const noexcept;
 
+	void Schedule(Context* ctx) noexcept;
+	void ScheduleAsync(Context* ctx) noexcept;
+	// may be called from any thread, ctx is made ready by this scheduler's dispatcher
+	void ScheduleRemote(Context* ctx) noexcept;
+	// fresh contexts of a batch launch, attached unless the policy detaches
+	// them in Awakened anyway, and handed to the policy in one call
+	void ScheduleBatch(Context* const* ctxs, std::size_t count) noexcept;
+	void ScheduleAsyncBatch(Context* const* ctxs, std::size_t count) noexcept;
+	// ctx got a new priority or deadline while it may sit in the ready queue
+	void PriorityChanged(Context* ctx) noexcept;
+
+	std::uint32_t GetId() const noexcept { return id_; }
 	Context* GetDispatcherContext() const noexcept { return dispatcherContext_.get(); }
 
+	// fibers currently attached to this scheduler, may be read from any thread
+	std::size_t GetWorkerCount() const noexcept { return workerCount_.load(std::memory_order_relaxed); }
+
+	// may be called from any thread while the scheduler exists
+	SchedulerStats GetStats() const noexcept;
+	// owner thread only, for launches and steals the scheduler does not see itself
+	void CountSpawn(std::uint64_t n = 1) noexcept { detail::Bump(counters_.spawns, n); }
+	void CountSteal() noexcept { detail::Bump(counters_.steals); }
+
+	// Starts measuring ready-queue waits and run slices, may be called from any
+	// thread and more than once. A fiber's wait is counted if the scheduler
+	// that made it ready measures, by the scheduler that resumes it.
+	void EnableLatencyHistograms();
+	bool LatencyHistogramsEnabled() const noexcept { return nullptr != latency_.load(std::memory_order_relaxed); }
+	// empty histograms while not enabled, may be called from any thread
+	SchedulerLatency GetLatency() const noexcept;
+
 	lutask::context::FiberContext Dispatch() noexcept;
 	lutask::context::FiberContext Terminate(Context* ctx) noexcept;
 
@@ -56,13 +146,20 @@ public:
 
 	bool WaitUntil(Context* ctx,
 		std::chrono::steady_clock::time_point const& tp) noexcept;
+	bool WaitUntil(Context* ctx,
+		std::chrono::steady_clock::time_point const& tp, std::unique_lock<std::mutex>& lk) noexcept;
+	bool WaitUntil(Context* ctx,
+		std::chrono::steady_clock::time_point const& tp, std::unique_lock<detail::Spinlock>& lk) noexcept;
 
 	void Suspend() noexcept;
 	void Suspend(std::unique_lock<std::mutex>& lk) noexcept;
+	void Suspend(std::unique_lock<detail::Spinlock>& lk) noexcept;
 
 	void AttachMainContext(Context* ctx) noexcept;
 	void AttachDispatcherContext(Context::Ptr ctx) noexcept;
 	void AttachWorkerContext(Context* ctx) noexcept;
+	// attaches a batch under one lock
+	void AttachWorkerContexts(Context* const* ctxs, std::size_t count) noexcept;
 	void DetachWorkerContext(Context* ctx) noexcept;
 };
 
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+namespace lutask
+{
+
+// A snapshot of one scheduler's counters, or the sum of several. Counts are
+// totals since the scheduler was created; Fibers and Sleeping are gauges
+// taken at the time of the snapshot.
+struct SchedulerStats
+{
+    std::uint64_t Switches = 0;       // contexts resumed by the dispatcher or handed over to directly
+    std::uint64_t Spawns = 0;         // fibers launched on this thread
+    std::uint64_t Terminations = 0;   // fibers that finished here
+    std::uint64_t Steals = 0;         // fibers taken from another worker's queue
+    std::uint64_t Migrations = 0;     // fibers that left through YieldOrigin()
+    std::uint64_t Wakeups = 0;        // times the dispatcher came back from SuspendUntil()
+    std::uint64_t IdleNs = 0;         // time spent in SuspendUntil()
+    std::uint64_t BusyNs = 0;         // time the thread ran the dispatcher or a fiber
+    std::uint64_t Fibers = 0;         // fibers attached right now
+    std::uint64_t Sleeping = 0;       // fibers in the sleep queue right now
+
+    SchedulerStats& operator+=(SchedulerStats const& other) noexcept
+    {
+        Switches += other.Switches;
+        Spawns += other.Spawns;
+        Terminations += other.Terminations;
+        Steals += other.Steals;
+        Migrations += other.Migrations;
+        Wakeups += other.Wakeups;
+        IdleNs += other.IdleNs;
+        BusyNs += other.BusyNs;
+        Fibers += other.Fibers;
+        Sleeping += other.Sleeping;
+        return *this;
+    }
+
+    friend SchedulerStats operator+(SchedulerStats l, SchedulerStats const& r) noexcept
+    {
+        l += r;
+        return l;
+    }
+};
+
+}
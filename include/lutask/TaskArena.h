@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace lutask
+{
+
+struct TaskArenaStats
+{
+    std::size_t Hits = 0;       // served from a free list
+    std::size_t Misses = 0;     // carved from a slab or fell through to operator new
+    std::size_t Slabs = 0;      // slabs taken from the system
+    std::size_t Cached = 0;     // blocks currently sitting in free lists
+};
+
+// Small-object arena for task objects and shared states. Blocks are carved out of
+// SlabSize slabs and recycled through thread-local free lists, one per Granularity
+// size class; a thread keeps at most LocalCapacity blocks per class and hands half
+// of the surplus to a global list. A block freed on another thread simply joins
+// that thread's list. Slabs are kept for the lifetime of the process.
+class TaskArena
+{
+public:
+    static constexpr std::size_t Granularity = 32;
+    static constexpr std::size_t MaxBlockSize = 512;
+    static constexpr std::size_t SlabSize = 64 * 1024;
+    static constexpr std::size_t LocalCapacity = 256;
+
+    static void* Allocate(std::size_t size);
+    static void Deallocate(void* vp, std::size_t size) noexcept;
+
+    static TaskArenaStats Stats() noexcept;
+};
+
+template<typename T>
+class TaskAllocator
+{
+public:
+    using value_type = T;
+
+    TaskAllocator() noexcept = default;
+
+    template<typename U>
+    TaskAllocator(TaskAllocator<U> const&) noexcept {}
+
+    T* allocate(std::size_t n)
+    {
+        if (alignof(T) > alignof(std::max_align_t))
+        {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+        }
+        return static_cast<T*>(TaskArena::Allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        if (alignof(T) > alignof(std::max_align_t))
+        {
+            ::operator delete(p, std::align_val_t(alignof(T)));
+            return;
+        }
+        TaskArena::Deallocate(p, n * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(TaskAllocator<U> const&) const noexcept { return true; }
+
+    template<typename U>
+    bool operator!=(TaskAllocator<U> const&) const noexcept { return false; }
+};
+
+}
@@ -1,44 +1,166 @@
 #pragma once
 
-//#include <vector>
-//#include <thread>
-//#include <mutex>
-//#include <queue>
-//
-//namespace lutask
-//{
-//class ITask;
-//class TaskQueue
-//{
-//public:
-//	TaskQueue() = default;
-//	TaskQueue(const TaskQueue& )
-//
-//private:
-//	std::queue<ITask*> q_;
-//	std::mutex m_;
-//};
-//
-//class ThreadPool 
-//{
-//public:
-//	ThreadPool(size_t numThread);
-//	~ThreadPool();
-//
-//	bool PushTask(ITask* task);
-//
-//private:
-//
-//
-//private:
-//	size_t numThread_;
-//	std::vector<std::thread> workers_;
-//	TaskQueue taskQueue_;
-//
-//	std::condition_variable cv_;
-//	std::mutex m_;
-//
-//	bool terminated_;
-//};
-//
-//}
\ No newline at end of file
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <lutask/ConditionVariableAny.h>
+#include <lutask/Context.h>
+#include <lutask/Exceptions.h>
+#include <lutask/LatencyHistogram.h>
+#include <lutask/SchedulerStats.h>
+#include <lutask/TaskArena.h>
+#include <lutask/WaitQueue.h>
+#include <lutask/detail/MPMCQueue.h>
+#include <lutask/detail/Spinlock.h>
+#include <lutask/future/PackagedTask.h>
+#include <lutask/schedule/IPolicy.h>
+
+namespace lutask
+{
+
+class Scheduler;
+
+// N worker threads, each running a dispatcher with a policy made by the
+// factory on that thread. Post() and Async() may be called from any thread,
+// fiber or not. A task waits in the pool's queue as a small closure and gets
+// its fiber only once a worker picks it up, so a backlog of millions costs no
+// stacks. Shutdown() waits for every posted task, then lets the workers
+// finish whatever fibers those tasks left behind and joins them.
+class ThreadPool
+{
+public:
+    using PolicyFactory = std::function<schedule::IPolicy*()>;
+
+    // work-stealing workers that sleep while there is nothing to steal; every
+    // call starts a WorkStealingGroup of its own, so the workers of one pool
+    // never steal from or wake those of another
+    static PolicyFactory DefaultPolicy();
+
+    // with pinThreads, worker i is bound to Topology::CpuAt(i): workers fill
+    // the cpus of one NUMA node before they spill to the next
+    explicit ThreadPool(std::size_t threadCount = std::thread::hardware_concurrency(),
+        PolicyFactory factory = ThreadPool::DefaultPolicy(), bool pinThreads = false);
+
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    std::size_t Size() const noexcept { return schedulers_.size(); }
+    // posted tasks that have not returned yet
+    std::size_t Pending() const noexcept { return pending_.load(std::memory_order_relaxed); }
+
+    // counters of one worker's scheduler; after Shutdown() what it had at exit
+    SchedulerStats GetStats(std::size_t index);
+    // the sum over all workers
+    SchedulerStats GetStats();
+
+    // turns on the latency histograms of every worker
+    void EnableLatencyHistograms();
+    // merged over all workers, what left workers had at exit included
+    SchedulerLatency GetLatency();
+
+    template<typename Fn, typename ...Args>
+    void Post(Fn&& fn, Args&& ...args)
+    {
+        typedef TaskImpl<typename std::decay<Fn>::type, typename std::decay<Args>::type...> task_type;
+
+        Enter();
+        Task* task = nullptr;
+        try
+        {
+            task = new task_type(std::forward<Fn>(fn), std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            Leave();
+            throw;
+        }
+        Submit(task);
+    }
+
+    template<typename Fn, typename ...Args>
+    Future<typename std::invoke_result<typename std::decay<Fn>::type, typename std::decay<Args>::type...>::type>
+    Async(Fn&& fn, Args&& ...args)
+    {
+        typedef typename std::invoke_result<typename std::decay<Fn>::type, typename std::decay<Args>::type...>::type result_type;
+
+        PackagedTask<result_type(typename std::decay<Args>::type...)> pt(std::allocator_arg, TaskAllocator<void>(), std::forward<Fn>(fn));
+        Future<result_type> f(pt.GetFuture());
+        Post(std::move(pt), std::forward<Args>(args)...);
+        return f;
+    }
+
+    // drain and stop, later posts from outside the pool throw; called by the destructor
+    void Shutdown();
+
+private:
+    struct Task
+    {
+        virtual ~Task() = default;
+        // destroys the task before invoking what it held
+        virtual void Run() = 0;
+
+        static void* operator new(std::size_t size) { return TaskArena::Allocate(size); }
+        static void operator delete(void* vp, std::size_t size) noexcept { TaskArena::Deallocate(vp, size); }
+    };
+
+    template<typename Fn, typename ...Args>
+    struct TaskImpl final : public Task
+    {
+        Fn fn_;
+        std::tuple<Args...> args_;
+
+        template<typename F, typename ...A>
+        explicit TaskImpl(F&& fn, A&& ...args)
+            : fn_(std::forward<F>(fn))
+            , args_(std::forward<A>(args)...)
+        {}
+
+        void Run() override
+        {
+            auto fn = std::move(fn_);
+            auto args = std::move(args_);
+            delete this;
+
+            std::apply(std::move(fn), std::move(args));
+        }
+    };
+
+    void Work(std::size_t index, bool pinThreads);
+    void Enter();
+    void Leave() noexcept;
+    void Submit(Task* task) noexcept;
+    void WakeIdle() noexcept;
+
+private:
+    PolicyFactory               factory_;
+    std::vector<std::thread>    threads_;
+    std::vector<Scheduler*>     schedulers_;
+    // final counters of workers that have left, schedulers_ is null for them
+    std::vector<SchedulerStats> retired_;
+    SchedulerLatency            retiredLatency_;
+    detail::MPMCQueue<Task*>    tasks_;
+    alignas(detail::CacheLineSize) std::atomic_size_t pending_{ 0 };
+    alignas(detail::CacheLineSize) std::atomic_size_t idle_{ 0 };
+    // set while a woken worker is on its way, it wakes the next one itself
+    std::atomic_bool            waking_{ false };
+    std::atomic_bool            stopping_{ false };
+
+    detail::Spinlock            splk_;
+    WaitQueue                   idleWorkers_;
+    bool                        done_{ false };
+
+    // the constructor and Shutdown() wait here
+    std::mutex                  mtx_;
+    ConditionVariableAny        cnd_;
+    std::size_t                 started_{ 0 };
+};
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <lutask/detail/IntrusiveList.h>
+
+namespace lutask
+{
+
+struct Context;
+
+// hook tag of the sleep queue
+struct SleepHookTag {};
+
+// Hierarchical hashed timer wheel keyed by Context::tp_. Timers are filed
+// under the tick their deadline rounds up to; Expire() checks the exact
+// deadlines of the current tick's timers, so a timer never fires early, and
+// NextDeadline() reports the exact earliest one, so it need not fire late
+// either. Insert and Remove are O(1), every tick expires a whole slot at once.
+class TimerWheel final
+{
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+    using Duration = std::chrono::steady_clock::duration;
+    using List = detail::IntrusiveList<Context, SleepHookTag>;
+
+    static constexpr std::size_t SlotBits = 6;
+    static constexpr std::size_t Slots = std::size_t(1) << SlotBits;
+    static constexpr std::size_t Levels = 4;
+
+private:
+    static constexpr std::uint32_t OverflowSlot = Levels * Slots;
+
+    Duration        tick_;
+    TimePoint       start_;
+    std::uint64_t   currentTick_{ 0 };
+    std::size_t     size_{ 0 };
+    std::uint64_t   occupied_[Levels]{};
+
+    List            slots_[Levels * Slots];
+    List            overflow_;
+    List            due_;
+
+    std::uint64_t ToTick(TimePoint const& tp) const noexcept;
+
+    void Link(Context* ctx) noexcept;
+    void Cascade(std::size_t level, std::size_t slot) noexcept;
+    void Tick(std::uint64_t tick) noexcept;
+    static TimePoint MinDeadline(List& list) noexcept;
+
+public:
+    explicit TimerWheel(Duration tick = std::chrono::milliseconds(1)) noexcept;
+
+    TimerWheel(TimerWheel const&) = delete;
+    TimerWheel& operator=(TimerWheel const&) = delete;
+
+    bool IsEmpty() const noexcept { return 0 == size_; }
+    std::size_t Size() const noexcept { return size_; }
+    Duration GetTick() const noexcept { return tick_; }
+
+    // restarts an empty wheel with another resolution
+    void Reset(Duration tick) noexcept;
+
+    void Insert(Context* ctx) noexcept;
+    void Remove(Context* ctx) noexcept;
+
+    // moves every timer whose deadline is not after now into expired
+    void Expire(TimePoint const& now, List& expired) noexcept;
+
+    // the exact deadline of the earliest timer, max() if none
+    TimePoint NextDeadline() noexcept;
+};
+
+}
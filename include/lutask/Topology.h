@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace lutask
+{
+
+struct NumaNode
+{
+    std::size_t Id = 0;
+    std::vector<std::size_t> Cpus;
+};
+
+struct NumaNodeStats
+{
+    std::size_t LocalSteals = 0;    // fibers stolen from a worker of the same node
+    std::size_t RemoteSteals = 0;   // fibers stolen from another node's worker
+    std::size_t MigrationsOut = 0;  // fibers another node stole from this one
+    std::size_t BindFailures = 0;   // BindToNode() calls for this node the kernel refused
+};
+
+// NUMA layout of the machine, read once from /sys/devices/system/node on Linux;
+// elsewhere, or when that is missing, every cpu belongs to node 0. Nodes are
+// indexed densely in the order the system lists them, Id keeps the system's number.
+class Topology
+{
+public:
+    static std::size_t NodeCount() noexcept;
+    static std::size_t CpuCount() noexcept;
+    static NumaNode const& Node(std::size_t index) noexcept;
+    static std::size_t NodeOfCpu(std::size_t cpu) noexcept;
+
+    // cpus ordered node by node, worker i of a compact placement runs on the i-th
+    static std::size_t CpuAt(std::size_t index) noexcept;
+
+    // binds the calling thread to cpu and makes its node the thread's node
+    static bool PinCurrentThread(std::size_t cpu) noexcept;
+    // the node of the calling thread: the pinned one, else where it first asked
+    static std::size_t CurrentNode() noexcept;
+
+    // asks the kernel to back [vp, vp + size) with memory of node; vp and size
+    // are whole pages of a mapping nothing else shares, the policy only takes
+    // effect for pages not touched yet. False if the kernel refused, which is
+    // counted in the node's stats; always true on a single node machine
+    static bool BindToNode(void* vp, std::size_t size, std::size_t node) noexcept;
+
+    static void CountSteal(std::size_t thiefNode, std::size_t victimNode) noexcept;
+    static NumaNodeStats Stats(std::size_t node) noexcept;
+};
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+namespace lutask
+{
+
+struct Context;
+class Scheduler;
+
+enum class ETraceEvent : std::uint8_t
+{
+    Spawn,      // a fiber was launched
+    Ready,      // a fiber entered a ready queue, possibly from another thread
+    Resume,     // a context got the thread
+    Suspend,    // the running fiber blocked or went to sleep
+    Yield,      // the running fiber gave way but stays ready
+    Terminate,  // the running fiber returned
+    Migrate     // the running fiber left for its origin through YieldOrigin()
+};
+
+// Opt-in timeline of what the dispatchers do. With LUTASK_TRACE defined the
+// scheduler records every switch into a ring of the calling thread while
+// recording is started; without it the hooks below expand to nothing and no
+// code of this class is reached. A ring keeps the latest events once full.
+// Rings are written without locks, read them after Stop() for a timeline
+// that does not change under the reader.
+class Trace
+{
+public:
+    static constexpr std::size_t DefaultCapacity = 1 << 16;
+
+    // whether this build records at all
+    static constexpr bool IsCompiledIn() noexcept
+    {
+#if defined(LUTASK_TRACE)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // eventsPerThread applies to rings of threads that have not recorded yet,
+    // rounded up to a power of two
+    static void Start(std::size_t eventsPerThread = DefaultCapacity) noexcept;
+    static void Stop() noexcept;
+    static bool IsRecording() noexcept { return recording_.load(std::memory_order_relaxed); }
+    // drops what was recorded, only while stopped
+    static void Clear() noexcept;
+
+    static void Record(ETraceEvent event, Context const* ctx, Scheduler const* sched) noexcept
+    {
+        if (IsRecording())
+        {
+            Append(event, ctx, sched);
+        }
+    }
+
+    // Chrome trace event format, opens in chrome://tracing and Perfetto: a
+    // track per scheduler with a slice per run of a context, instants for the
+    // other events and an async "ready" span per fiber from Ready to Resume.
+    // Returns the number of recorded events written.
+    static std::size_t WriteChromeJson(std::ostream& out);
+    static bool WriteChromeJson(char const* path);
+
+    // ids of contexts, 0 is never handed out
+    static std::uint64_t NextId() noexcept;
+
+private:
+    static void Append(ETraceEvent event, Context const* ctx, Scheduler const* sched) noexcept;
+
+    static std::atomic_bool recording_;
+};
+
+}
+
+#if defined(LUTASK_TRACE)
+#define LUTASK_TRACE_EVENT(event, ctx, sched) ::lutask::Trace::Record(::lutask::ETraceEvent::event, (ctx), (sched))
+#else
+#define LUTASK_TRACE_EVENT(event, ctx, sched) ((void)0)
+#endif
@@ -1,27 +1,47 @@
 #pragma once
 
+#include <chrono>
 #include <mutex>
-#include <queue>
 #include <memory>
+#include <lutask/detail/IntrusiveList.h>
+#include <lutask/detail/Spinlock.h>
 
 namespace lutask
 {
 
 struct Context;
+struct WaitHookTag {};
+
+// A context blocks on one queue at a time, so the queue links it through the
+// context's own hook, which lives on the waiting fiber's stack, and never
+// allocates. The queue has no lock of its own: every call is made under the
+// lock its owner passes to the waits, and a waiter releases that lock only
+// after it is switched out, so a notifier on another thread never sees a
+// context that is still running.
 class WaitQueue final
 {
 public:
     WaitQueue() = default;
 
-    void SuspendAndWait(Context* activeCtx);
     void SuspendAndWait(std::unique_lock<std::mutex>& lk, Context* activeCtx);
-    void NotifyOne();
+    void SuspendAndWait(std::unique_lock<detail::Spinlock>& lk, Context* activeCtx);
+    // returns with lk held again; false if the deadline passed before a notify reached activeCtx
+    bool SuspendAndWaitUntil(std::unique_lock<std::mutex>& lk, Context* activeCtx,
+        std::chrono::steady_clock::time_point const& tp);
+    bool SuspendAndWaitUntil(std::unique_lock<detail::Spinlock>& lk, Context* activeCtx,
+        std::chrono::steady_clock::time_point const& tp);
+    // the woken context, nullptr if nobody was waiting
+    Context* NotifyOne();
     void NotifyAll();
 
     bool IsEmpty() const;
 
 private:
-    std::queue<Context*> waits_;
+    template<typename Lock>
+    bool SuspendAndWaitUntil_(Lock& lk, Context* activeCtx,
+        std::chrono::steady_clock::time_point const& tp);
+
+    detail::IntrusiveList<Context, WaitHookTag> waits_;
 };
 
-}
\ No newline at end of file
+}
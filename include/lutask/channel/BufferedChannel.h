@@ -0,0 +1,379 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <system_error>
+#include <utility>
+#include <lutask/Context.h>
+#include <lutask/Exceptions.h>
+#include <lutask/WaitQueue.h>
+#include <lutask/channel/ChannelOp.h>
+#include <lutask/detail/Spinlock.h>
+#include <lutask/detail/MPMCQueue.h>
+
+namespace lutask
+{
+
+// Bounded channel over a lock-free ring. Push and pop only touch the ring while
+// it has room and items; a fiber that finds it full or empty parks on a WaitQueue
+// and the other side takes the lock only when somebody is parked. After Close()
+// pushes fail, pops drain what is left and then report Closed.
+template<typename T>
+class BufferedChannel
+{
+public:
+    using ValueType = T;
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    class Iterator;
+
+    explicit BufferedChannel(std::size_t capacity)
+        : ring_(capacity)
+    {
+        if (capacity < 2 || 0 != (capacity & (capacity - 1)))
+        {
+            throw FiberError(std::make_error_code(std::errc::invalid_argument),
+                "lutask: buffered channel capacity must be a power of two");
+        }
+    }
+
+    ~BufferedChannel()
+    {
+        Close();
+    }
+
+    BufferedChannel(BufferedChannel const&) = delete;
+    BufferedChannel& operator=(BufferedChannel const&) = delete;
+
+    std::size_t Capacity() const noexcept { return ring_.Capacity(); }
+    bool IsClosed() const noexcept { return closed_.load(std::memory_order_acquire); }
+
+    void Close() noexcept
+    {
+        std::unique_lock<detail::Spinlock> lk(splk_);
+        closed_.store(true, std::memory_order_release);
+        WakeUp(producers_, waitingProducers_, static_cast<std::size_t>(-1));
+        WakeUp(consumers_, waitingConsumers_, static_cast<std::size_t>(-1));
+    }
+
+    EChannelOp TryPush(T const& value) { return TryPushImpl(value); }
+    EChannelOp TryPush(T&& value) { return TryPushImpl(std::move(value)); }
+
+    EChannelOp Push(T const& value) { return PushImpl(value, nullptr); }
+    EChannelOp Push(T&& value) { return PushImpl(std::move(value), nullptr); }
+
+    template<typename Rep, typename Period>
+    EChannelOp PushWaitFor(T value, std::chrono::duration<Rep, Period> const& timeout)
+    {
+        TimePoint tp = std::chrono::steady_clock::now() + timeout;
+        return PushImpl(std::move(value), &tp);
+    }
+
+    EChannelOp PushWaitUntil(T value, TimePoint const& tp)
+    {
+        return PushImpl(std::move(value), &tp);
+    }
+
+    EChannelOp TryPop(T& value)
+    {
+        if (ring_.TryPop(value))
+        {
+            NotifyProducers(1);
+            return EChannelOp::Success;
+        }
+        return IsClosed() ? ClosedOrItem(value) : EChannelOp::Empty;
+    }
+
+    EChannelOp Pop(T& value) { return PopImpl(value, nullptr); }
+
+    template<typename Rep, typename Period>
+    EChannelOp PopWaitFor(T& value, std::chrono::duration<Rep, Period> const& timeout)
+    {
+        TimePoint tp = std::chrono::steady_clock::now() + timeout;
+        return PopImpl(value, &tp);
+    }
+
+    EChannelOp PopWaitUntil(T& value, TimePoint const& tp)
+    {
+        return PopImpl(value, &tp);
+    }
+
+    T ValuePop()
+    {
+        T value;
+        if (EChannelOp::Success != Pop(value))
+        {
+            throw FiberError(std::make_error_code(std::errc::operation_not_permitted),
+                "lutask: channel is closed");
+        }
+        return value;
+    }
+
+    // Pushes [first, last) and wakes the consumers once per burst instead of once
+    // per item. Returns how many were pushed, less than the range only if closed.
+    template<typename InputIt>
+    std::size_t PushN(InputIt first, InputIt last)
+    {
+        std::size_t pushed = 0;
+        while (first != last)
+        {
+            if (IsClosed())
+                break;
+
+            std::size_t burst = 0;
+            while (first != last && ring_.TryPush(*first))
+            {
+                ++first;
+                ++burst;
+            }
+            if (0 != burst)
+            {
+                NotifyConsumers(burst);
+                pushed += burst;
+                continue;
+            }
+
+            // full, park for one item and go on with the fast path
+            if (EChannelOp::Success != Push(*first))
+                break;
+            ++first;
+            ++pushed;
+        }
+        return pushed;
+    }
+
+    // Waits for at least one item, then takes what is there up to count.
+    // Returns 0 only once the channel is closed and drained.
+    template<typename OutputIt>
+    std::size_t PopN(OutputIt out, std::size_t count)
+    {
+        if (0 == count)
+            return 0;
+
+        T value;
+        if (EChannelOp::Success != Pop(value))
+            return 0;
+        *out++ = std::move(value);
+
+        std::size_t popped = 1;
+        while (popped < count && ring_.TryPop(value))
+        {
+            *out++ = std::move(value);
+            ++popped;
+        }
+        if (1 < popped)
+        {
+            NotifyProducers(popped - 1);
+        }
+        return popped;
+    }
+
+    Iterator begin() { return Iterator(this); }
+    Iterator end() { return Iterator(); }
+
+private:
+    template<typename U>
+    EChannelOp TryPushImpl(U&& value)
+    {
+        if (IsClosed())
+            return EChannelOp::Closed;
+
+        if (ring_.TryPush(std::forward<U>(value)) == false)
+            return EChannelOp::Full;
+
+        NotifyConsumers(1);
+        return EChannelOp::Success;
+    }
+
+    template<typename U>
+    EChannelOp PushImpl(U&& value, TimePoint const* tp)
+    {
+        // a failed TryPush leaves value untouched, it is only moved on success
+        EChannelOp op = TryPushImpl(std::forward<U>(value));
+        if (EChannelOp::Full != op)
+            return op;
+
+        Context* ctx = Context::Active();
+        std::unique_lock<detail::Spinlock> lk(splk_);
+        for (;;)
+        {
+            if (IsClosed())
+            {
+                op = EChannelOp::Closed;
+                break;
+            }
+
+            // announced before the retry, a consumer that pops after it will see us;
+            // whoever wakes us takes the count back
+            waitingProducers_.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (ring_.TryPush(std::forward<U>(value)))
+            {
+                waitingProducers_.fetch_sub(1, std::memory_order_relaxed);
+                op = EChannelOp::Success;
+                break;
+            }
+            if (nullptr == tp)
+            {
+                producers_.SuspendAndWait(lk, ctx);
+                lk.lock();
+            }
+            else if (producers_.SuspendAndWaitUntil(lk, ctx, *tp) == false)
+            {
+                waitingProducers_.fetch_sub(1, std::memory_order_relaxed);
+                op = EChannelOp::Timeout;
+                break;
+            }
+        }
+        lk.unlock();
+
+        if (EChannelOp::Success == op)
+        {
+            NotifyConsumers(1);
+        }
+        return op;
+    }
+
+    EChannelOp PopImpl(T& value, TimePoint const* tp)
+    {
+        if (ring_.TryPop(value))
+        {
+            NotifyProducers(1);
+            return EChannelOp::Success;
+        }
+
+        EChannelOp op;
+        Context* ctx = Context::Active();
+        std::unique_lock<detail::Spinlock> lk(splk_);
+        for (;;)
+        {
+            if (IsClosed())
+            {
+                op = ClosedOrItem(value);
+                break;
+            }
+
+            waitingConsumers_.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (ring_.TryPop(value))
+            {
+                waitingConsumers_.fetch_sub(1, std::memory_order_relaxed);
+                op = EChannelOp::Success;
+                break;
+            }
+            if (nullptr == tp)
+            {
+                consumers_.SuspendAndWait(lk, ctx);
+                lk.lock();
+            }
+            else if (consumers_.SuspendAndWaitUntil(lk, ctx, *tp) == false)
+            {
+                waitingConsumers_.fetch_sub(1, std::memory_order_relaxed);
+                op = EChannelOp::Timeout;
+                break;
+            }
+        }
+        lk.unlock();
+
+        if (EChannelOp::Success == op)
+        {
+            NotifyProducers(1);
+        }
+        return op;
+    }
+
+    // a push may still have been publishing when Close() came in
+    EChannelOp ClosedOrItem(T& value)
+    {
+        return ring_.TryPop(value) ? EChannelOp::Success : EChannelOp::Closed;
+    }
+
+    void NotifyConsumers(std::size_t count)
+    {
+        // pairs with the fetch_add of a parking consumer, one of us sees the other
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (0 == waitingConsumers_.load(std::memory_order_relaxed))
+            return;
+
+        std::unique_lock<detail::Spinlock> lk(splk_);
+        WakeUp(consumers_, waitingConsumers_, count);
+    }
+
+    void NotifyProducers(std::size_t count)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (0 == waitingProducers_.load(std::memory_order_relaxed))
+            return;
+
+        std::unique_lock<detail::Spinlock> lk(splk_);
+        WakeUp(producers_, waitingProducers_, count);
+    }
+
+    // the waker takes the count of every fiber it wakes, so the fast path stops
+    // taking the lock as soon as nobody is parked any more
+    static void WakeUp(WaitQueue& waiters, std::atomic_size_t& waiting, std::size_t count) noexcept
+    {
+        while (0 != count-- && nullptr != waiters.NotifyOne())
+        {
+            waiting.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    detail::BoundedMPMCQueue<T> ring_;
+    std::atomic_bool            closed_{ false };
+    alignas(detail::CacheLineSize) std::atomic_size_t waitingProducers_{ 0 };
+    alignas(detail::CacheLineSize) std::atomic_size_t waitingConsumers_{ 0 };
+    detail::Spinlock            splk_;
+    WaitQueue                   producers_;
+    WaitQueue                   consumers_;
+};
+
+// input iterator popping until the channel is closed and drained
+template<typename T>
+class BufferedChannel<T>::Iterator
+{
+public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    Iterator() noexcept = default;
+
+    explicit Iterator(BufferedChannel* chan)
+        : chan_(chan)
+    {
+        Increment();
+    }
+
+    bool operator==(Iterator const& other) const noexcept { return chan_ == other.chan_; }
+    bool operator!=(Iterator const& other) const noexcept { return chan_ != other.chan_; }
+
+    Iterator& operator++()
+    {
+        Increment();
+        return *this;
+    }
+
+    reference operator*() noexcept { return value_; }
+    pointer operator->() noexcept { return &value_; }
+
+private:
+    void Increment()
+    {
+        if (nullptr != chan_ && EChannelOp::Success != chan_->Pop(value_))
+        {
+            chan_ = nullptr;
+        }
+    }
+
+    BufferedChannel* chan_{ nullptr };
+    T value_{};
+};
+
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+namespace lutask
+{
+
+enum class EChannelOp
+{
+    Success,
+    Empty,
+    Full,
+    Closed,
+    Timeout
+};
+
+}
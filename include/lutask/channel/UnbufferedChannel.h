@@ -0,0 +1,365 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <system_error>
+#include <utility>
+#include <lutask/Context.h>
+#include <lutask/Exceptions.h>
+#include <lutask/WaitQueue.h>
+#include <lutask/channel/ChannelOp.h>
+#include <lutask/detail/Spinlock.h>
+
+namespace lutask
+{
+
+// Rendezvous channel: Push() returns only once a consumer took the value. The
+// producer offers a slot living on its own stack, a consumer moves the value out
+// and wakes it; there is never more than one value in flight. TryPush() never
+// waits for the take, it moves the value straight into a parked consumer.
+template<typename T>
+class UnbufferedChannel
+{
+public:
+    using ValueType = T;
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    class Iterator;
+
+    UnbufferedChannel() = default;
+
+    ~UnbufferedChannel()
+    {
+        Close();
+    }
+
+    UnbufferedChannel(UnbufferedChannel const&) = delete;
+    UnbufferedChannel& operator=(UnbufferedChannel const&) = delete;
+
+    bool IsClosed() const noexcept
+    {
+        std::unique_lock<detail::Spinlock> lk(splk_);
+        return closed_;
+    }
+
+    void Close() noexcept
+    {
+        std::unique_lock<detail::Spinlock> lk(splk_);
+        closed_ = true;
+        if (nullptr != slot_)
+        {
+            slot_->waiter.NotifyAll();
+        }
+        producers_.NotifyAll();
+        consumers_.NotifyAll();
+    }
+
+    // succeeds only if a consumer is already parked on the channel
+    EChannelOp TryPush(T value) { return PushImpl(value, nullptr, true); }
+
+    EChannelOp Push(T value) { return PushImpl(value, nullptr, false); }
+
+    template<typename Rep, typename Period>
+    EChannelOp PushWaitFor(T value, std::chrono::duration<Rep, Period> const& timeout)
+    {
+        TimePoint tp = std::chrono::steady_clock::now() + timeout;
+        return PushImpl(value, &tp, false);
+    }
+
+    EChannelOp PushWaitUntil(T value, TimePoint const& tp)
+    {
+        return PushImpl(value, &tp, false);
+    }
+
+    // succeeds only if a producer is already offering a value
+    EChannelOp TryPop(T& value) { return PopImpl(value, nullptr, true); }
+
+    EChannelOp Pop(T& value) { return PopImpl(value, nullptr, false); }
+
+    template<typename Rep, typename Period>
+    EChannelOp PopWaitFor(T& value, std::chrono::duration<Rep, Period> const& timeout)
+    {
+        TimePoint tp = std::chrono::steady_clock::now() + timeout;
+        return PopImpl(value, &tp, false);
+    }
+
+    EChannelOp PopWaitUntil(T& value, TimePoint const& tp)
+    {
+        return PopImpl(value, &tp, false);
+    }
+
+    T ValuePop()
+    {
+        T value;
+        if (EChannelOp::Success != Pop(value))
+        {
+            throw FiberError(std::make_error_code(std::errc::operation_not_permitted),
+                "lutask: channel is closed");
+        }
+        return value;
+    }
+
+    // every value is its own rendezvous, these only save the caller the loop
+    template<typename InputIt>
+    std::size_t PushN(InputIt first, InputIt last)
+    {
+        std::size_t pushed = 0;
+        for (; first != last && EChannelOp::Success == Push(*first); ++first)
+        {
+            ++pushed;
+        }
+        return pushed;
+    }
+
+    template<typename OutputIt>
+    std::size_t PopN(OutputIt out, std::size_t count)
+    {
+        if (0 == count)
+            return 0;
+
+        T value;
+        if (EChannelOp::Success != Pop(value))
+            return 0;
+        *out++ = std::move(value);
+
+        std::size_t popped = 1;
+        while (popped < count && EChannelOp::Success == TryPop(value))
+        {
+            *out++ = std::move(value);
+            ++popped;
+        }
+        return popped;
+    }
+
+    Iterator begin() { return Iterator(this); }
+    Iterator end() { return Iterator(); }
+
+private:
+    struct Slot
+    {
+        T* value;
+        bool taken{ false };
+        WaitQueue waiter;
+    };
+
+    // a consumer parked on the channel, on its own stack
+    struct Receiver
+    {
+        T* value;
+        Context* ctx;
+        bool filled{ false };
+        Receiver* next{ nullptr };
+    };
+
+    void Unlink(Receiver* receiver) noexcept
+    {
+        for (Receiver** link = &receivers_; nullptr != *link; link = &(*link)->next)
+        {
+            if (*link == receiver)
+            {
+                *link = receiver->next;
+                return;
+            }
+        }
+    }
+
+    Receiver* FindReceiver(Context* ctx) noexcept
+    {
+        for (Receiver* receiver = receivers_; nullptr != receiver; receiver = receiver->next)
+        {
+            if (receiver->ctx == ctx)
+                return receiver;
+        }
+        return nullptr;
+    }
+
+    // value is moved out by the consumer that takes it
+    EChannelOp PushImpl(T& value, TimePoint const* tp, bool tryOnly)
+    {
+        Context* ctx = Context::Active();
+        std::unique_lock<detail::Spinlock> lk(splk_);
+
+        // wait until no other producer is offering
+        for (;;)
+        {
+            if (closed_)
+                return EChannelOp::Closed;
+            if (tryOnly && (nullptr != slot_ || nullptr == receivers_))
+                return EChannelOp::Full;
+            if (nullptr == slot_)
+                break;
+
+            if (nullptr == tp)
+            {
+                producers_.SuspendAndWait(lk, ctx);
+                lk.lock();
+            }
+            else if (producers_.SuspendAndWaitUntil(lk, ctx, *tp) == false)
+            {
+                return EChannelOp::Timeout;
+            }
+        }
+
+        if (tryOnly)
+        {
+            // a parked consumer may have timed out without having run yet,
+            // only one that the notify actually woke can take the value
+            Receiver* receiver = FindReceiver(consumers_.NotifyOne());
+            if (nullptr == receiver)
+                return EChannelOp::Full;
+
+            // it runs only once lk is gone, a throwing move is a spurious wakeup
+            *receiver->value = std::move(value);
+            receiver->filled = true;
+            Unlink(receiver);
+            return EChannelOp::Success;
+        }
+
+        Slot slot;
+        slot.value = &value;
+        slot_ = &slot;
+        consumers_.NotifyOne();
+
+        EChannelOp op = EChannelOp::Success;
+        while (slot.taken == false)
+        {
+            if (closed_)
+            {
+                op = EChannelOp::Closed;
+                break;
+            }
+            if (nullptr == tp)
+            {
+                slot.waiter.SuspendAndWait(lk, ctx);
+                lk.lock();
+            }
+            else if (slot.waiter.SuspendAndWaitUntil(lk, ctx, *tp) == false && slot.taken == false)
+            {
+                op = EChannelOp::Timeout;
+                break;
+            }
+        }
+
+        if (&slot == slot_)
+        {
+            // withdrawn before anybody took it
+            slot_ = nullptr;
+        }
+        producers_.NotifyOne();
+        return op;
+    }
+
+    EChannelOp PopImpl(T& value, TimePoint const* tp, bool tryOnly)
+    {
+        Context* ctx = Context::Active();
+        std::unique_lock<detail::Spinlock> lk(splk_);
+
+        EChannelOp op = EChannelOp::Success;
+        Receiver receiver{ &value, ctx };
+        receiver.next = receivers_;
+        receivers_ = &receiver;
+        bool timedOut = false;
+        for (;;)
+        {
+            if (receiver.filled)
+                break;
+            if (nullptr != slot_)
+            {
+                Slot* slot = slot_;
+                slot_ = nullptr;
+                value = std::move(*slot->value);
+                slot->taken = true;
+                slot->waiter.NotifyOne();
+                break;
+            }
+            if (closed_)
+            {
+                op = EChannelOp::Closed;
+                break;
+            }
+            if (tryOnly)
+            {
+                op = EChannelOp::Empty;
+                break;
+            }
+            // an offer posted while the deadline fired is still taken above
+            if (timedOut)
+            {
+                op = EChannelOp::Timeout;
+                break;
+            }
+
+            if (nullptr == tp)
+            {
+                consumers_.SuspendAndWait(lk, ctx);
+                lk.lock();
+            }
+            else if (consumers_.SuspendAndWaitUntil(lk, ctx, *tp) == false)
+            {
+                timedOut = true;
+            }
+        }
+        if (receiver.filled == false)
+        {
+            Unlink(&receiver);
+        }
+        return op;
+    }
+
+private:
+    mutable detail::Spinlock splk_;
+    bool                closed_{ false };
+    // the offer of the producer currently in the rendezvous
+    Slot*               slot_{ nullptr };
+    // consumers in PopImpl(), TryPush() hands its value to one of them
+    Receiver*           receivers_{ nullptr };
+    WaitQueue           producers_;
+    WaitQueue           consumers_;
+};
+
+template<typename T>
+class UnbufferedChannel<T>::Iterator
+{
+public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    Iterator() noexcept = default;
+
+    explicit Iterator(UnbufferedChannel* chan)
+        : chan_(chan)
+    {
+        Increment();
+    }
+
+    bool operator==(Iterator const& other) const noexcept { return chan_ == other.chan_; }
+    bool operator!=(Iterator const& other) const noexcept { return chan_ != other.chan_; }
+
+    Iterator& operator++()
+    {
+        Increment();
+        return *this;
+    }
+
+    reference operator*() noexcept { return value_; }
+    pointer operator->() noexcept { return &value_; }
+
+private:
+    void Increment()
+    {
+        if (nullptr != chan_ && EChannelOp::Success != chan_->Pop(value_))
+        {
+            chan_ = nullptr;
+        }
+    }
+
+    UnbufferedChannel* chan_{ nullptr };
+    T value_{};
+};
+
+}
@@ -7,6 +7,8 @@
 
 #include <type_traits>
 #include <cassert>
+#include <functional>
+#include <utility>
 
 #include <lutask/Preallocated.h>
 #include <lutask/context/fcontext.h>
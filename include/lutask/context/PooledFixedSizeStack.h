@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <lutask/context/StackTraits.h>
+#include <lutask/context/StackContext.h>
+
+namespace lutask {
+namespace context {
+
+struct StackPoolStats
+{
+    std::size_t Hits = 0;       // served from a free list
+    std::size_t Misses = 0;     // fell through to a fresh allocation
+    std::size_t Cached = 0;     // stacks currently held by the pool
+    std::size_t HighWater = 0;  // peak of Cached over the life of the process
+};
+
+// Recycles fiber stacks through thread-local free lists. A thread keeps at most
+// LocalCapacity stacks per size, the surplus goes to a global overflow pool
+// bounded by GlobalCapacity, anything beyond that is returned to the system.
+// The overflow pool keeps a list per NUMA node; a stack remembers the node it
+// was allocated on and a thread of another node hands it back to that list.
+// On a multi-node machine a fresh stack is a mapping of its own, bound to the
+// allocating thread's node; elsewhere it comes from malloc.
+class StackPool
+{
+public:
+    static constexpr std::size_t LocalCapacity = 64;
+    static constexpr std::size_t GlobalCapacity = 1024;
+
+    static void* Allocate(std::size_t size);
+    static void Deallocate(void* vp, std::size_t size) noexcept;
+
+    static StackPoolStats Stats() noexcept;
+};
+
+template<typename _StackTraitsTy>
+class BasicPooledFixedSizeStack {
+private:
+    std::size_t     size_;
+
+public:
+    BasicPooledFixedSizeStack( std::size_t size = _StackTraitsTy::DefaultSize() ) noexcept
+        : size_( size) { }
+
+    StackContext Allocate() 
+    {
+        void * vp = StackPool::Allocate( size_);
+        StackContext sctx;
+        sctx.Size = size_;
+        sctx.Sp = static_cast< char * >( vp) + sctx.Size;
+        return sctx;
+    }
+
+    void Deallocate(StackContext& sctx) noexcept 
+    {
+        assert(sctx.Sp);
+
+        void *vp = static_cast<char*>(sctx.Sp) - sctx.Size;
+        StackPool::Deallocate(vp, sctx.Size);
+    }
+};
+
+using PooledFixedSizeStack = BasicPooledFixedSizeStack<StackTraits>;
+}}
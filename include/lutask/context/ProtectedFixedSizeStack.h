@@ -0,0 +1,7 @@
+#pragma once
+
+#if defined(_WIN32)
+# error "lutask: ProtectedFixedSizeStack is not implemented for windows yet"
+#else
+# include <lutask/context/posix/ProtectedFixedSizeStack.h>
+#endif
@@ -0,0 +1,115 @@
+#pragma once
+
+extern "C" {
+#include <sys/mman.h>
+}
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <new>
+#include <system_error>
+#include <lutask/context/StackTraits.h>
+#include <lutask/context/StackContext.h>
+
+#if defined(MAP_ANON) && ! defined(MAP_ANONYMOUS)
+# define MAP_ANONYMOUS MAP_ANON
+#endif
+
+namespace lutask {
+namespace context {
+
+struct ProtectedStackStats
+{
+    std::size_t Stacks = 0;         // live stacks
+    std::size_t ReservedBytes = 0;  // address space mapped, guard pages included
+    std::size_t ResidentBytes = 0;  // pages actually backed by memory
+};
+
+// Sits at the top of every protected stack mapping, above the fiber's first
+// frame, so freeing a stack needs no lookup; it links the live stacks too.
+struct alignas(16) ProtectedStackHeader
+{
+    ProtectedStackHeader* prev;
+    ProtectedStackHeader* next;
+    void* base;
+    std::size_t size;   // mapping length, guard page included
+};
+
+// Book-keeping of every live protected stack so that fleets can be sized
+// from what the fibers really touch instead of what they reserve. Register
+// and Unregister link the header under a mutex and never allocate. Stats()
+// probes every stack while holding that mutex, so no stack can be unmapped
+// under it; allocating or freeing a protected stack waits for the scan.
+class ProtectedStackRegistry
+{
+public:
+    static void Register(ProtectedStackHeader* header) noexcept;
+    static void Unregister(ProtectedStackHeader* header) noexcept;
+
+    static std::size_t ResidentBytes(StackContext const& sctx) noexcept;
+    static ProtectedStackStats Stats();
+};
+
+// Reserves the stack with mmap and relies on demand paging, only the pages a
+// fiber touches are committed. The lowest page is a PROT_NONE guard so an
+// overflow faults instead of silently corrupting the neighbouring memory.
+template<typename _StackTraitsTy>
+class BasicProtectedFixedSizeStack {
+private:
+    std::size_t     size_;
+
+public:
+    BasicProtectedFixedSizeStack( std::size_t size = _StackTraitsTy::DefaultSize() ) noexcept
+        : size_( size) { }
+
+    StackContext Allocate() 
+    {
+        // round up to whole pages and add one for the guard
+        const std::size_t pages = (size_ + _StackTraitsTy::PageSize() - 1) / _StackTraitsTy::PageSize();
+        const std::size_t size = (pages + 1) * _StackTraitsTy::PageSize();
+
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_NORESERVE)
+        flags |= MAP_NORESERVE;
+#endif
+#if defined(MAP_STACK)
+        flags |= MAP_STACK;
+#endif
+        void * vp = ::mmap( nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if ( MAP_FAILED == vp) {
+            throw std::bad_alloc();
+        }
+
+        // conforming to POSIX.1-2001
+        if ( 0 != ::mprotect( vp, _StackTraitsTy::PageSize(), PROT_NONE) ) {
+            const int error = errno;
+            ::munmap( vp, size);
+            throw std::system_error( error, std::system_category(), "lutask: mprotect() of the guard page failed");
+        }
+
+        // [guard page][stack ... ][header]
+        ProtectedStackHeader * header = ::new ( static_cast< char * >( vp) + size - sizeof( ProtectedStackHeader) )
+            ProtectedStackHeader{ nullptr, nullptr, vp, size };
+        ProtectedStackRegistry::Register( header);
+
+        StackContext sctx;
+        sctx.Size = size - sizeof( ProtectedStackHeader);
+        sctx.Sp = header;
+        return sctx;
+    }
+
+    void Deallocate(StackContext& sctx) noexcept 
+    {
+        assert(sctx.Sp);
+
+        ProtectedStackHeader* header = static_cast<ProtectedStackHeader*>(sctx.Sp);
+        void* vp = header->base;
+        const std::size_t size = header->size;
+        ProtectedStackRegistry::Unregister(header);
+        ::munmap(vp, size);
+    }
+};
+
+using ProtectedFixedSizeStack = BasicProtectedFixedSizeStack<StackTraits>;
+}}
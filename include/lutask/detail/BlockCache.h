@@ -0,0 +1,337 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <lutask/detail/MPMCQueue.h>
+#include <lutask/detail/OwnerCounter.h>
+
+namespace lutask {
+namespace detail {
+
+// Singly linked LIFO threaded through the free blocks themselves, so moving a
+// block between lists never allocates.
+class FreeList
+{
+private:
+    struct Block
+    {
+        Block* next;
+    };
+
+    Block* head_{ nullptr };
+    std::size_t count_{ 0 };
+
+public:
+    static constexpr std::size_t MinBlockSize = sizeof(Block);
+
+    bool IsEmpty() const noexcept { return nullptr == head_; }
+    std::size_t Size() const noexcept { return count_; }
+
+    void Push(void* vp) noexcept
+    {
+        Block* block = static_cast<Block*>(vp);
+        block->next = head_;
+        head_ = block;
+        ++count_;
+    }
+
+    void* Pop() noexcept
+    {
+        Block* block = head_;
+        head_ = block->next;
+        --count_;
+        return block;
+    }
+};
+
+struct BlockCacheStats
+{
+    std::size_t Hits = 0;
+    std::size_t Misses = 0;
+    std::size_t Cached = 0;
+    std::size_t HighWater = 0;  // only kept with Traits::TrackHighWater
+};
+
+// Size-class block cache behind StackPool and TaskArena. Every thread keeps up
+// to Traits::LocalCapacity blocks per class in lists of its own and trades
+// them in batches of half that with global lists, one set per shard (a NUMA
+// node for stacks), under a mutex. The global lists hold at most
+// Traits::GlobalCapacity blocks, Traits::Release(vp) gets the rest back.
+//
+//   Traits::Classes, Traits::Shards        list counts, shards are clamped
+//   Traits::LocalCapacity, GlobalCapacity  block limits per class / overall
+//   Traits::TrackHighWater                 keep the peak of all cached blocks
+//   Traits::CurrentShard() noexcept        the calling thread's shard
+//   Traits::Release(void*) noexcept        takes a block the cache can't keep
+//
+// The peak is taken of one shared count, which every thread brings up to
+// date once its own changes add up to DriftLimit blocks either way, so it
+// may miss a short spike of fewer than that many blocks per thread.
+//
+// The cache never allocates, blocks only have to be MinBlockSize bytes.
+template<typename Traits>
+class BlockCache
+{
+private:
+    static constexpr std::size_t Classes = Traits::Classes;
+    static constexpr std::size_t Shards = Traits::Shards;
+    static constexpr std::ptrdiff_t DriftLimit = 16;
+
+    struct Local;
+
+    struct Global
+    {
+        std::mutex mtx;
+        FreeList free[Shards][Classes];
+        std::size_t cached = 0;
+
+        // counters of threads that already exited
+        std::size_t retiredHits = 0;
+        std::size_t retiredMisses = 0;
+
+        // live caches, linked through Local::prev/next
+        Local* caches = nullptr;
+
+        // blocks cached anywhere and their peak, with Traits::TrackHighWater
+        alignas(CacheLineSize) std::atomic<std::ptrdiff_t> total{ 0 };
+        std::atomic<std::ptrdiff_t> highWater{ 0 };
+
+        void Add(std::ptrdiff_t n) noexcept
+        {
+            if (Traits::TrackHighWater)
+            {
+                const std::ptrdiff_t now = total.fetch_add(n, std::memory_order_relaxed) + n;
+                std::ptrdiff_t peak = highWater.load(std::memory_order_relaxed);
+                while (peak < now && highWater.compare_exchange_weak(peak, now, std::memory_order_relaxed) == false)
+                {
+                }
+            }
+        }
+
+        // must be called with mtx held, false if the block went to Release
+        bool Put(std::size_t shard, std::size_t cls, void* vp) noexcept
+        {
+            if (cached < Traits::GlobalCapacity)
+            {
+                free[shard][cls].Push(vp);
+                ++cached;
+                return true;
+            }
+            Traits::Release(vp);
+            return false;
+        }
+
+        // a cached block leaving a thread's lists
+        void Move(std::size_t shard, std::size_t cls, void* vp) noexcept
+        {
+            if (Put(shard, cls, vp) == false)
+            {
+                Add(-1);
+            }
+        }
+    };
+
+    static Global& GetGlobal() noexcept
+    {
+        static Global global;
+        return global;
+    }
+
+    struct Local
+    {
+        FreeList free[Classes];
+
+        std::atomic_size_t hits{ 0 };
+        std::atomic_size_t misses{ 0 };
+        std::atomic_size_t cached{ 0 };
+        // change of cached blocks not yet added to Global::total
+        std::atomic<std::ptrdiff_t> drift{ 0 };
+
+        Local* prev = nullptr;
+        Local* next = nullptr;
+
+        Local() noexcept
+        {
+            Global& g = GetGlobal();
+            std::unique_lock<std::mutex> lk(g.mtx);
+            next = g.caches;
+            if (nullptr != next)
+            {
+                next->prev = this;
+            }
+            g.caches = this;
+        }
+
+        ~Local()
+        {
+            Global& g = GetGlobal();
+            const std::size_t shard = CurrentShard();
+            std::unique_lock<std::mutex> lk(g.mtx);
+            for (std::size_t cls = 0; cls < Classes; ++cls)
+            {
+                while (free[cls].IsEmpty() == false)
+                {
+                    g.Move(shard, cls, free[cls].Pop());
+                }
+            }
+            g.retiredHits += hits.load(std::memory_order_relaxed);
+            g.retiredMisses += misses.load(std::memory_order_relaxed);
+            g.Add(drift.load(std::memory_order_relaxed));
+
+            (nullptr != prev ? prev->next : g.caches) = next;
+            if (nullptr != next)
+            {
+                next->prev = prev;
+            }
+            Destroyed() = true;
+        }
+
+        void Track(std::ptrdiff_t n) noexcept
+        {
+            if (Traits::TrackHighWater)
+            {
+                const std::ptrdiff_t now = drift.load(std::memory_order_relaxed) + n;
+                if (now < DriftLimit && -DriftLimit < now)
+                {
+                    drift.store(now, std::memory_order_relaxed);
+                    return;
+                }
+                drift.store(0, std::memory_order_relaxed);
+                GetGlobal().Add(now);
+            }
+        }
+
+        // moves up to LocalCapacity / 2 blocks of the shard's global list here
+        void Refill(std::size_t cls) noexcept
+        {
+            Global& g = GetGlobal();
+            const std::size_t shard = CurrentShard();
+            std::unique_lock<std::mutex> lk(g.mtx);
+            FreeList& from = g.free[shard][cls];
+            std::size_t n = (std::min)(from.Size(), Traits::LocalCapacity / 2);
+            g.cached -= n;
+            Bump(cached, n);
+            while (n-- > 0)
+            {
+                free[cls].Push(from.Pop());
+            }
+        }
+
+        // keeps LocalCapacity / 2 blocks, hands the rest to the global list
+        void Spill(std::size_t cls) noexcept
+        {
+            Global& g = GetGlobal();
+            const std::size_t shard = CurrentShard();
+            std::unique_lock<std::mutex> lk(g.mtx);
+            Drop(cached, free[cls].Size() - Traits::LocalCapacity / 2);
+            while (free[cls].Size() > Traits::LocalCapacity / 2)
+            {
+                g.Move(shard, cls, free[cls].Pop());
+            }
+        }
+    };
+
+    static bool& Destroyed() noexcept
+    {
+        thread_local bool destroyed = false;
+        return destroyed;
+    }
+
+    static std::size_t Clamp(std::size_t shard) noexcept
+    {
+        return (std::min)(shard, Shards - 1);
+    }
+
+    static std::size_t CurrentShard() noexcept
+    {
+        return Clamp(Traits::CurrentShard());
+    }
+
+    // nullptr while the thread's storage is torn down, blocks may still be
+    // released then
+    static Local* GetLocal() noexcept
+    {
+        if (Destroyed())
+            return nullptr;
+
+        thread_local Local local;
+        return &local;
+    }
+
+public:
+    static constexpr std::size_t MinBlockSize = FreeList::MinBlockSize;
+
+    // a cached block of class cls, nullptr on a miss
+    static void* Pop(std::size_t cls) noexcept
+    {
+        Local* local = GetLocal();
+        if (nullptr == local)
+            return nullptr;
+
+        FreeList& free = local->free[cls];
+        if (free.IsEmpty())
+        {
+            local->Refill(cls);
+            if (free.IsEmpty())
+            {
+                Bump(local->misses);
+                return nullptr;
+            }
+        }
+        Bump(local->hits);
+        Drop(local->cached);
+        local->Track(-1);
+        return free.Pop();
+    }
+
+    // caches a block of class cls that belongs to shard
+    static void Push(std::size_t cls, std::size_t shard, void* vp) noexcept
+    {
+        shard = Clamp(shard);
+        Local* local = GetLocal();
+        if (nullptr == local || CurrentShard() != shard)
+        {
+            Global& g = GetGlobal();
+            std::unique_lock<std::mutex> lk(g.mtx);
+            if (g.Put(shard, cls, vp))
+            {
+                g.Add(1);
+            }
+            return;
+        }
+
+        FreeList& free = local->free[cls];
+        free.Push(vp);
+        Bump(local->cached);
+        local->Track(1);
+        if (free.Size() > Traits::LocalCapacity)
+        {
+            local->Spill(cls);
+        }
+    }
+
+    static BlockCacheStats Stats() noexcept
+    {
+        Global& g = GetGlobal();
+        std::unique_lock<std::mutex> lk(g.mtx);
+
+        BlockCacheStats stats;
+        stats.Hits = g.retiredHits;
+        stats.Misses = g.retiredMisses;
+        stats.Cached = g.cached;
+        std::ptrdiff_t total = g.total.load(std::memory_order_relaxed);
+        for (Local* local = g.caches; nullptr != local; local = local->next)
+        {
+            stats.Hits += local->hits.load(std::memory_order_relaxed);
+            stats.Misses += local->misses.load(std::memory_order_relaxed);
+            stats.Cached += local->cached.load(std::memory_order_relaxed);
+            total += local->drift.load(std::memory_order_relaxed);
+        }
+        stats.HighWater = static_cast<std::size_t>((std::max)(total, g.highWater.load(std::memory_order_relaxed)));
+        return stats;
+    }
+};
+
+}}
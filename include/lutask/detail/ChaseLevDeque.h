@@ -0,0 +1,173 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lutask {
+namespace detail {
+
+// Chase-Lev work-stealing deque (Le, Pop, Cohen, Zappa Nardelli, PPoPP'13).
+// The owner thread pushes and pops at the bottom, any other thread may steal
+// from the top. Retired buffers are kept until destruction because a thief
+// may still be reading from them.
+template<typename T>
+class ChaseLevDeque
+{
+private:
+    static constexpr std::size_t CacheLineSize = 64;
+
+    class Array
+    {
+    private:
+        std::size_t capacity_;
+        std::atomic<T*>* items_;
+
+    public:
+        explicit Array(std::size_t capacity)
+            : capacity_(capacity)
+            , items_(new std::atomic<T*>[capacity])
+        {
+            assert(0 == (capacity & (capacity - 1)));
+        }
+
+        ~Array() { delete[] items_; }
+
+        Array(Array const&) = delete;
+        Array& operator=(Array const&) = delete;
+
+        std::size_t Capacity() const noexcept { return capacity_; }
+
+        T* Get(std::int64_t idx) const noexcept
+        {
+            return items_[static_cast<std::size_t>(idx) & (capacity_ - 1)].load(std::memory_order_relaxed);
+        }
+
+        void Put(std::int64_t idx, T* item) noexcept
+        {
+            items_[static_cast<std::size_t>(idx) & (capacity_ - 1)].store(item, std::memory_order_relaxed);
+        }
+
+        Array* Grow(std::int64_t bottom, std::int64_t top) const
+        {
+            Array* a = new Array(capacity_ * 2);
+            for (std::int64_t i = top; i != bottom; ++i)
+            {
+                a->Put(i, Get(i));
+            }
+            return a;
+        }
+    };
+
+    alignas(CacheLineSize) std::atomic<std::int64_t> top_{ 0 };
+    alignas(CacheLineSize) std::atomic<std::int64_t> bottom_{ 0 };
+    alignas(CacheLineSize) std::atomic<Array*> array_;
+    std::vector<Array*> retired_{};
+
+public:
+    explicit ChaseLevDeque(std::size_t capacity = 1024)
+        : array_(new Array(capacity))
+    { }
+
+    ~ChaseLevDeque()
+    {
+        for (Array* a : retired_)
+        {
+            delete a;
+        }
+        delete array_.load(std::memory_order_relaxed);
+    }
+
+    ChaseLevDeque(ChaseLevDeque const&) = delete;
+    ChaseLevDeque& operator=(ChaseLevDeque const&) = delete;
+
+    bool IsEmpty() const noexcept
+    {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+        return b <= t;
+    }
+
+    std::size_t Size() const noexcept
+    {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? static_cast<std::size_t>(b - t) : 0;
+    }
+
+    // owner only
+    void Push(T* item)
+    {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        Array* a = array_.load(std::memory_order_relaxed);
+
+        if (b - t > static_cast<std::int64_t>(a->Capacity()) - 1)
+        {
+            Array* bigger = a->Grow(b, t);
+            retired_.push_back(a);
+            array_.store(bigger, std::memory_order_release);
+            a = bigger;
+        }
+
+        a->Put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // owner only
+    T* Pop() noexcept
+    {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Array* a = array_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+
+        T* item = nullptr;
+        if (t <= b)
+        {
+            item = a->Get(b);
+            if (t == b)
+            {
+                // last element, race against thieves
+                if (!top_.compare_exchange_strong(t, t + 1,
+                    std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    item = nullptr;
+                }
+                bottom_.store(b + 1, std::memory_order_relaxed);
+            }
+        }
+        else
+        {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // any thread
+    T* Steal() noexcept
+    {
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom_.load(std::memory_order_acquire);
+
+        if (t < b)
+        {
+            Array* a = array_.load(std::memory_order_acquire);
+            T* item = a->Get(t);
+            if (!top_.compare_exchange_strong(t, t + 1,
+                std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                return nullptr;
+            }
+            return item;
+        }
+        return nullptr;
+    }
+};
+
+}}
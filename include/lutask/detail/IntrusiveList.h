@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+
+namespace lutask {
+namespace detail {
+
+// Base hook for IntrusiveList. The tag lets one object sit in several lists
+// at once, one hook per tag.
+template<typename Tag>
+struct ListHook
+{
+    ListHook* prev_{ nullptr };
+    ListHook* next_{ nullptr };
+
+    bool IsLinked() const noexcept { return nullptr != next_; }
+};
+
+// Circular doubly linked list threaded through hooks embedded in the
+// elements, link and unlink are O(1) and never allocate.
+template<typename T, typename Tag>
+class IntrusiveList
+{
+private:
+    using Hook = ListHook<Tag>;
+
+    Hook root_;
+    std::size_t size_{ 0 };
+
+    static T* Owner(Hook* hook) noexcept { return static_cast<T*>(hook); }
+
+public:
+    IntrusiveList() noexcept
+    {
+        root_.prev_ = &root_;
+        root_.next_ = &root_;
+    }
+
+    ~IntrusiveList() { assert(IsEmpty()); }
+
+    IntrusiveList(IntrusiveList const&) = delete;
+    IntrusiveList& operator=(IntrusiveList const&) = delete;
+
+    bool IsEmpty() const noexcept { return root_.next_ == &root_; }
+    std::size_t Size() const noexcept { return size_; }
+
+    T* Front() noexcept { return IsEmpty() ? nullptr : Owner(root_.next_); }
+
+    void PushBack(T* item) noexcept
+    {
+        Hook* hook = item;
+        assert(!hook->IsLinked());
+        hook->prev_ = root_.prev_;
+        hook->next_ = &root_;
+        root_.prev_->next_ = hook;
+        root_.prev_ = hook;
+        ++size_;
+    }
+
+    void PushFront(T* item) noexcept
+    {
+        Hook* hook = item;
+        assert(!hook->IsLinked());
+        hook->prev_ = &root_;
+        hook->next_ = root_.next_;
+        root_.next_->prev_ = hook;
+        root_.next_ = hook;
+        ++size_;
+    }
+
+    T* PopFront() noexcept
+    {
+        if (IsEmpty())
+            return nullptr;
+
+        T* item = Owner(root_.next_);
+        Remove(item);
+        return item;
+    }
+
+    // unlinking an element that is not linked is a no-op
+    void Remove(T* item) noexcept
+    {
+        Hook* hook = item;
+        if (!hook->IsLinked())
+            return;
+
+        hook->prev_->next_ = hook->next_;
+        hook->next_->prev_ = hook->prev_;
+        hook->prev_ = nullptr;
+        hook->next_ = nullptr;
+        --size_;
+    }
+
+    // moves every element of other to the back of this list
+    void Splice(IntrusiveList& other) noexcept
+    {
+        if (other.IsEmpty())
+            return;
+
+        Hook* first = other.root_.next_;
+        Hook* last = other.root_.prev_;
+        first->prev_ = root_.prev_;
+        last->next_ = &root_;
+        root_.prev_->next_ = first;
+        root_.prev_ = last;
+        size_ += other.size_;
+
+        other.root_.prev_ = &other.root_;
+        other.root_.next_ = &other.root_;
+        other.size_ = 0;
+    }
+
+    template<typename Fn>
+    void ForEach(Fn&& fn)
+    {
+        for (Hook* hook = root_.next_; hook != &root_;)
+        {
+            Hook* next = hook->next_;
+            fn(Owner(hook));
+            hook = next;
+        }
+    }
+};
+
+}}
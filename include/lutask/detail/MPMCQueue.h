@@ -0,0 +1,482 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace lutask {
+namespace detail {
+
+static constexpr std::size_t CacheLineSize = 64;
+
+inline void CpuRelax() noexcept
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+// spins with a growing number of pause instructions, then yields the thread
+class Backoff
+{
+private:
+    static constexpr unsigned SpinLimit = 6;
+    unsigned step_{ 0 };
+
+public:
+    void Spin() noexcept
+    {
+        for (unsigned i = 0; i < (1u << (step_ < SpinLimit ? step_ : SpinLimit)); ++i)
+        {
+            CpuRelax();
+        }
+        if (step_ <= SpinLimit)
+        {
+            ++step_;
+        }
+    }
+
+    void Snooze() noexcept
+    {
+        if (step_ <= SpinLimit)
+        {
+            Spin();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+};
+
+// Bounded lock-free MPMC ring (D. Vyukov). Every cell carries a sequence number
+// telling producers and consumers whose turn it is, so push and pop each cost
+// one CAS on their own padded index.
+template<typename T>
+class BoundedMPMCQueue
+{
+private:
+    struct Cell
+    {
+        std::atomic_size_t sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    alignas(CacheLineSize) std::atomic_size_t enqueuePos_{ 0 };
+    alignas(CacheLineSize) std::atomic_size_t dequeuePos_{ 0 };
+    alignas(CacheLineSize) Cell* cells_;
+    std::size_t mask_;
+
+public:
+    // capacity is rounded up to a power of two
+    explicit BoundedMPMCQueue(std::size_t capacity)
+    {
+        std::size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        mask_ = size - 1;
+        cells_ = static_cast<Cell*>(::operator new(sizeof(Cell) * size));
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            ::new (&cells_[i].sequence) std::atomic_size_t(i);
+        }
+    }
+
+    ~BoundedMPMCQueue()
+    {
+        T item;
+        while (TryPop(item))
+        {
+        }
+        ::operator delete(cells_);
+    }
+
+    BoundedMPMCQueue(BoundedMPMCQueue const&) = delete;
+    BoundedMPMCQueue& operator=(BoundedMPMCQueue const&) = delete;
+
+    std::size_t Capacity() const noexcept { return mask_ + 1; }
+
+    template<typename U>
+    bool TryPush(U&& item)
+    {
+        Cell* cell;
+        std::size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            cell = &cells_[pos & mask_];
+            std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            std::intptr_t diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (0 == diff)
+            {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                // a full lap behind the consumers
+                return false;
+            }
+            else
+            {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        ::new (&cell->storage) T(std::forward<U>(item));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& item)
+    {
+        Cell* cell;
+        std::size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            cell = &cells_[pos & mask_];
+            std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            std::intptr_t diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+            if (0 == diff)
+            {
+                if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        T* value = std::launder(reinterpret_cast<T*>(&cell->storage));
+        item = std::move(*value);
+        value->~T();
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool IsEmpty() const noexcept
+    {
+        return dequeuePos_.load(std::memory_order_acquire) >= enqueuePos_.load(std::memory_order_acquire);
+    }
+};
+
+// Unbounded lock-free MPMC queue made of fixed-size segments, after the segment
+// queue of crossbeam. Head and tail are indices that also encode the position
+// inside the current segment; a thread reserves a slot with one CAS on the index
+// and only then touches the segment, so a segment can be freed by whichever reader
+// finishes with it last without any epoch or hazard pointer.
+template<typename T>
+class MPMCQueue
+{
+private:
+    // the lowest index bit flags "head is not in the last segment"
+    static constexpr std::size_t Shift = 1;
+    static constexpr std::size_t HasNext = 1;
+    // one slot per lap is kept free, it marks a segment change in progress
+    static constexpr std::size_t Lap = 64;
+    static constexpr std::size_t SegmentCapacity = Lap - 1;
+
+    static constexpr std::uint32_t Write = 1;
+    static constexpr std::uint32_t Read = 2;
+    static constexpr std::uint32_t Destroy = 4;
+
+    struct Slot
+    {
+        std::atomic_uint32_t state{ 0 };
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        void WaitWrite() const noexcept
+        {
+            Backoff backoff;
+            while (0 == (state.load(std::memory_order_acquire) & Write))
+            {
+                backoff.Snooze();
+            }
+        }
+
+        T* Value() noexcept { return std::launder(reinterpret_cast<T*>(&storage)); }
+    };
+
+    struct Segment
+    {
+        std::atomic<Segment*> next{ nullptr };
+        Slot slots[SegmentCapacity];
+
+        Segment* WaitNext() const noexcept
+        {
+            Backoff backoff;
+            for (;;)
+            {
+                Segment* n = next.load(std::memory_order_acquire);
+                if (nullptr != n)
+                    return n;
+                backoff.Snooze();
+            }
+        }
+
+    };
+
+    struct Position
+    {
+        std::atomic_size_t index{ 0 };
+        std::atomic<Segment*> segment{ nullptr };
+    };
+
+    alignas(CacheLineSize) Position head_;
+    alignas(CacheLineSize) Position tail_;
+    // the last segment drained, kept for the next one needed so a queue
+    // that stays within a segment or two stops allocating
+    alignas(CacheLineSize) std::atomic<Segment*> spare_{ nullptr };
+
+    Segment* NewSegment()
+    {
+        Segment* segment = spare_.exchange(nullptr, std::memory_order_acquire);
+        if (nullptr == segment)
+            return new Segment();
+
+        segment->next.store(nullptr, std::memory_order_relaxed);
+        for (Slot& slot : segment->slots)
+        {
+            slot.state.store(0, std::memory_order_relaxed);
+        }
+        return segment;
+    }
+
+    void DeleteSegment(Segment* segment) noexcept
+    {
+        Segment* expected = nullptr;
+        if (spare_.compare_exchange_strong(expected, segment, std::memory_order_release, std::memory_order_relaxed) == false)
+        {
+            delete segment;
+        }
+    }
+
+    // readers of slots [start, SegmentCapacity - 1) that are still busy
+    // inherit the job of freeing the segment
+    void Release(Segment* segment, std::size_t start) noexcept
+    {
+        for (std::size_t i = start; i < SegmentCapacity - 1; ++i)
+        {
+            Slot& slot = segment->slots[i];
+            if (0 == (slot.state.load(std::memory_order_acquire) & Read)
+                && 0 == (slot.state.fetch_or(Destroy, std::memory_order_acq_rel) & Read))
+            {
+                return;
+            }
+        }
+        DeleteSegment(segment);
+    }
+
+public:
+    MPMCQueue() = default;
+
+    ~MPMCQueue()
+    {
+        std::size_t head = head_.index.load(std::memory_order_relaxed) & ~HasNext;
+        std::size_t tail = tail_.index.load(std::memory_order_relaxed) & ~HasNext;
+        Segment* segment = head_.segment.load(std::memory_order_relaxed);
+
+        while (head != tail)
+        {
+            std::size_t offset = (head >> Shift) % Lap;
+            if (offset < SegmentCapacity)
+            {
+                segment->slots[offset].Value()->~T();
+            }
+            else
+            {
+                Segment* next = segment->next.load(std::memory_order_relaxed);
+                delete segment;
+                segment = next;
+            }
+            head += (1 << Shift);
+        }
+        delete segment;
+        delete spare_.load(std::memory_order_relaxed);
+    }
+
+    MPMCQueue(MPMCQueue const&) = delete;
+    MPMCQueue& operator=(MPMCQueue const&) = delete;
+
+    template<typename U>
+    void Push(U&& item)
+    {
+        Backoff backoff;
+        std::size_t tail = tail_.index.load(std::memory_order_acquire);
+        Segment* segment = tail_.segment.load(std::memory_order_acquire);
+        Segment* nextSegment = nullptr;
+
+        for (;;)
+        {
+            std::size_t offset = (tail >> Shift) % Lap;
+
+            // another producer is installing the next segment
+            if (SegmentCapacity == offset)
+            {
+                backoff.Snooze();
+                tail = tail_.index.load(std::memory_order_acquire);
+                segment = tail_.segment.load(std::memory_order_acquire);
+                continue;
+            }
+
+            // allocated before the slot is reserved, so the segment change is short
+            if (offset + 1 == SegmentCapacity && nullptr == nextSegment)
+            {
+                nextSegment = NewSegment();
+            }
+
+            if (nullptr == segment)
+            {
+                Segment* first = NewSegment();
+                if (tail_.segment.compare_exchange_strong(segment, first, std::memory_order_release, std::memory_order_relaxed))
+                {
+                    head_.segment.store(first, std::memory_order_release);
+                    segment = first;
+                }
+                else
+                {
+                    DeleteSegment(nextSegment);
+                    nextSegment = first;
+                    tail = tail_.index.load(std::memory_order_acquire);
+                    segment = tail_.segment.load(std::memory_order_acquire);
+                    continue;
+                }
+            }
+
+            std::size_t newTail = tail + (1 << Shift);
+            if (tail_.index.compare_exchange_weak(tail, newTail, std::memory_order_seq_cst, std::memory_order_acquire))
+            {
+                if (offset + 1 == SegmentCapacity)
+                {
+                    assert(nullptr != nextSegment);
+                    tail_.segment.store(nextSegment, std::memory_order_release);
+                    tail_.index.store(newTail + (1 << Shift), std::memory_order_release);
+                    segment->next.store(nextSegment, std::memory_order_release);
+                    nextSegment = nullptr;
+                }
+                else if (nullptr != nextSegment)
+                {
+                    DeleteSegment(nextSegment);
+                }
+
+                Slot& slot = segment->slots[offset];
+                ::new (&slot.storage) T(std::forward<U>(item));
+                slot.state.fetch_or(Write, std::memory_order_release);
+                return;
+            }
+
+            segment = tail_.segment.load(std::memory_order_acquire);
+            backoff.Spin();
+        }
+    }
+
+    bool TryPop(T& item)
+    {
+        Backoff backoff;
+        std::size_t head = head_.index.load(std::memory_order_acquire);
+        Segment* segment = head_.segment.load(std::memory_order_acquire);
+
+        for (;;)
+        {
+            std::size_t offset = (head >> Shift) % Lap;
+
+            // another consumer is moving on to the next segment
+            if (SegmentCapacity == offset)
+            {
+                backoff.Snooze();
+                head = head_.index.load(std::memory_order_acquire);
+                segment = head_.segment.load(std::memory_order_acquire);
+                continue;
+            }
+
+            std::size_t newHead = head + (1 << Shift);
+            if (0 == (newHead & HasNext))
+            {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                std::size_t tail = tail_.index.load(std::memory_order_relaxed);
+
+                if ((head >> Shift) == (tail >> Shift))
+                {
+                    return false;
+                }
+
+                // head and tail live in different segments
+                if ((head >> Shift) / Lap != (tail >> Shift) / Lap)
+                {
+                    newHead |= HasNext;
+                }
+            }
+
+            // the first push has not installed its segment yet
+            if (nullptr == segment)
+            {
+                backoff.Snooze();
+                head = head_.index.load(std::memory_order_acquire);
+                segment = head_.segment.load(std::memory_order_acquire);
+                continue;
+            }
+
+            if (head_.index.compare_exchange_weak(head, newHead, std::memory_order_seq_cst, std::memory_order_acquire))
+            {
+                if (offset + 1 == SegmentCapacity)
+                {
+                    Segment* next = segment->WaitNext();
+                    std::size_t nextIndex = (newHead & ~HasNext) + (1 << Shift);
+                    if (nullptr != next->next.load(std::memory_order_relaxed))
+                    {
+                        nextIndex |= HasNext;
+                    }
+                    head_.segment.store(next, std::memory_order_release);
+                    head_.index.store(nextIndex, std::memory_order_release);
+                }
+
+                Slot& slot = segment->slots[offset];
+                slot.WaitWrite();
+                T* value = slot.Value();
+                item = std::move(*value);
+                value->~T();
+
+                if (offset + 1 == SegmentCapacity)
+                {
+                    Release(segment, 0);
+                }
+                else if (slot.state.fetch_or(Read, std::memory_order_acq_rel) & Destroy)
+                {
+                    Release(segment, offset + 1);
+                }
+                return true;
+            }
+
+            segment = head_.segment.load(std::memory_order_acquire);
+            backoff.Spin();
+        }
+    }
+
+    bool IsEmpty() const noexcept
+    {
+        std::size_t head = head_.index.load(std::memory_order_seq_cst);
+        std::size_t tail = tail_.index.load(std::memory_order_seq_cst);
+        return (head >> Shift) == (tail >> Shift);
+    }
+};
+
+}}
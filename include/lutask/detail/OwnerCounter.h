@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+
+namespace lutask {
+namespace detail {
+
+// Counters written by a single thread and read by any: the owner updates them
+// with a relaxed load and store instead of a locked read-modify-write, a reader
+// on another thread sees some recent value.
+
+template<typename T>
+inline void Bump(std::atomic<T>& counter, typename std::atomic<T>::value_type n = 1) noexcept
+{
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+template<typename T>
+inline void Drop(std::atomic<T>& counter, typename std::atomic<T>::value_type n = 1) noexcept
+{
+    counter.store(counter.load(std::memory_order_relaxed) - n, std::memory_order_relaxed);
+}
+
+template<typename T>
+inline void RaiseTo(std::atomic<T>& counter, typename std::atomic<T>::value_type value) noexcept
+{
+    if (counter.load(std::memory_order_relaxed) < value)
+    {
+        counter.store(value, std::memory_order_relaxed);
+    }
+}
+
+template<typename T>
+inline void LowerTo(std::atomic<T>& counter, typename std::atomic<T>::value_type value) noexcept
+{
+    if (value < counter.load(std::memory_order_relaxed))
+    {
+        counter.store(value, std::memory_order_relaxed);
+    }
+}
+
+}}
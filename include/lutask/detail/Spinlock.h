@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <lutask/detail/MPMCQueue.h>
+
+namespace lutask {
+namespace detail {
+
+// Test-and-test-and-set lock for sections of a few instructions. It is never
+// held across a blocking call; a fiber that parks under it hands the unlock
+// to the context switch, so the holder is always running.
+class Spinlock
+{
+private:
+    std::atomic_bool locked_{ false };
+
+public:
+    Spinlock() noexcept = default;
+
+    Spinlock(Spinlock const&) = delete;
+    Spinlock& operator=(Spinlock const&) = delete;
+
+    void lock() noexcept
+    {
+        Backoff backoff;
+        for (;;)
+        {
+            if (locked_.exchange(true, std::memory_order_acquire) == false)
+                return;
+
+            // spin on a plain load, the cache line stays shared until it is released
+            while (locked_.load(std::memory_order_relaxed))
+            {
+                backoff.Snooze();
+            }
+        }
+    }
+
+    bool try_lock() noexcept
+    {
+        return locked_.load(std::memory_order_relaxed) == false
+            && locked_.exchange(true, std::memory_order_acquire) == false;
+    }
+
+    void unlock() noexcept
+    {
+        locked_.store(false, std::memory_order_release);
+    }
+};
+
+}}
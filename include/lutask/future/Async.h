@@ -1,25 +1,164 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <lutask/Fiber.h>
+#include <lutask/TaskArena.h>
+#include <lutask/context/PooledFixedSizeStack.h>
 #include <lutask/future/PackagedTask.h>
 
 namespace lutask
 {
 
-template< typename Fn, typename ... Args >
+namespace detail
+{
+
+// a task object living on top of its fiber's stack, the object keeps a
+// reference to the fiber so the stack outlives the fiber until the future is gone
+struct StackSlot
+{
+    void* address;
+    std::size_t size;   // bytes reserved at address
+    Context* owner;
+};
+
+template<typename T>
+class StackSlotAllocator
+{
+public:
+    using value_type = T;
+
+    explicit StackSlotAllocator(StackSlot* slot) noexcept : slot_(slot) {}
+
+    template<typename U>
+    StackSlotAllocator(StackSlotAllocator<U> const& other) noexcept : slot_(other.slot_) {}
+
+    // anything but the one object the slot was sized for goes to the heap
+    T* allocate(std::size_t n)
+    {
+        if (1 == n && sizeof(T) <= slot_->size && alignof(T) <= alignof(std::max_align_t))
+        {
+            return static_cast<T*>(slot_->address);
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t) noexcept
+    {
+        if (static_cast<void*>(p) != slot_->address)
+        {
+            ::operator delete(p);
+        }
+        // may hand the stack back to its allocator
+        if (nullptr != slot_->owner)
+        {
+            intrusive_ptr_release(slot_->owner);
+        }
+    }
+
+    template<typename U>
+    bool operator==(StackSlotAllocator<U> const& other) const noexcept { return slot_ == other.slot_; }
+
+    template<typename U>
+    bool operator!=(StackSlotAllocator<U> const& other) const noexcept { return slot_ != other.slot_; }
+
+private:
+    template<typename U>
+    friend class StackSlotAllocator;
+
+    StackSlot* slot_;
+};
+
+// task objects up to this size share the fiber's stack, larger ones go to the heap
+constexpr std::size_t MaxStackSlotSize = 1024;
+
+}
+
+// the task object is taken from alloc and the fiber stack from salloc
+template< typename StackAllocator, typename Allocator, typename Fn, typename ... Args >
 Future<
     typename std::result_of<typename std::decay< Fn >::type(typename std::decay< Args >::type ...)>::type
 >
-Async(Fn&& fn, Args ... args)
+Async(std::allocator_arg_t, StackAllocator&& salloc, Allocator const& alloc, Fn&& fn, Args ... args)
 {
     typedef typename std::invoke_result<Fn, Args...>::type result_type;
 
-    PackagedTask<result_type(typename std::decay< Args >::type...)> pt(std::forward<Fn>(fn));
+    PackagedTask<result_type(typename std::decay< Args >::type...)> pt(std::allocator_arg, alloc, std::forward<Fn>(fn));
     Future<result_type> f(pt.GetFuture());
-    lutask::Fiber(lutask::ELaunch::Async, std::move(pt), std::forward<Args>(args)...).Detach();
+    lutask::Fiber(lutask::ELaunch::Async, std::allocator_arg, std::forward<StackAllocator>(salloc), std::move(pt), std::forward<Args>(args)...).Detach();
     return f;
 }
 
+// the task object, which is also the shared state, is placed on top of the
+// fiber's stack, so a launch costs a single stack allocation
+template< typename StackAllocator, typename Fn, typename ... Args >
+Future<
+    typename std::result_of<typename std::decay< Fn >::type(typename std::decay< Args >::type ...)>::type
+>
+Async(std::allocator_arg_t, StackAllocator&& salloc, Fn&& fn, Args ... args)
+{
+    typedef typename std::invoke_result<Fn, Args...>::type result_type;
+    typedef PackagedTask<result_type(typename std::decay< Args >::type...)> task_type;
+    typedef TaskObject<typename std::decay<Fn>::type, detail::StackSlotAllocator<void>,
+        result_type, typename std::decay< Args >::type...> object_type;
+
+    if constexpr (sizeof(object_type) + sizeof(detail::StackSlot) > detail::MaxStackSlotSize
+        || alignof(object_type) > alignof(std::max_align_t))
+    {
+        return Async(std::allocator_arg, std::forward<StackAllocator>(salloc), TaskAllocator<void>(),
+            std::forward<Fn>(fn), std::forward<Args>(args)...);
+    }
+    else
+    {
+        typename std::decay<StackAllocator>::type owner{ salloc };
+        context::StackContext sctx = owner.Allocate();
+
+        // [slot][task object][worker context][fiber stack ...
+        std::uintptr_t top = reinterpret_cast<std::uintptr_t>(sctx.Sp);
+        std::uintptr_t slotAddress = (top - sizeof(detail::StackSlot)) & ~static_cast<std::uintptr_t>(alignof(detail::StackSlot) - 1);
+        std::uintptr_t objectAddress = (slotAddress - sizeof(object_type)) & ~static_cast<std::uintptr_t>(alignof(std::max_align_t) - 1);
+
+        detail::StackSlot* slot = ::new (reinterpret_cast<void*>(slotAddress))
+            detail::StackSlot{ reinterpret_cast<void*>(objectAddress), slotAddress - objectAddress, nullptr };
+
+        Context::Ptr ctx;
+        Future<result_type> f;
+        try
+        {
+            task_type pt(std::allocator_arg, detail::StackSlotAllocator<void>(slot), std::forward<Fn>(fn));
+            f = pt.GetFuture();
+            ctx = PlaceWorkerContext(lutask::ELaunch::Async, sctx, slot->address,
+                std::forward<StackAllocator>(salloc), std::move(pt), std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            // nothing may point into the stack any more
+            f = Future<result_type>();
+            owner.Deallocate(sctx);
+            throw;
+        }
+
+        slot->owner = ctx.get();
+        intrusive_ptr_add_ref(ctx.get());
+        lutask::Fiber(std::move(ctx)).Detach();
+        return f;
+    }
+}
+
+// a steady stream of Async calls is served from the thread-local stack pool
+template< typename Fn, typename ... Args,
+    typename = typename std::enable_if<!std::is_same<typename std::decay<Fn>::type, std::allocator_arg_t>::value>::type >
+Future<
+    typename std::result_of<typename std::decay< Fn >::type(typename std::decay< Args >::type ...)>::type
+>
+Async(Fn&& fn, Args ... args)
+{
+    return Async(std::allocator_arg, context::PooledFixedSizeStack(), std::forward<Fn>(fn), std::forward<Args>(args)...);
+}
+
 }
 
-#define async_await(f, ...) lutask::Async(f, __VA_ARGS__);
\ No newline at end of file
+#define async_await(f, ...) lutask::Async(f, __VA_ARGS__);
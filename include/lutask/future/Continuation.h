@@ -0,0 +1,245 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <vector>
+#include <lutask/Fiber.h>
+#include <lutask/future/Future.h>
+#include <lutask/future/PackagedTask.h>
+#include <lutask/future/Promise.h>
+
+namespace lutask
+{
+
+// Promise.h may be the header that pulled this one in
+template<typename R>
+class Promise;
+
+template<typename Sequence>
+struct WhenAnyResult
+{
+    std::size_t Index = static_cast<std::size_t>(-1);
+    Sequence Futures;
+};
+
+namespace detail
+{
+
+template<typename T>
+struct IsFuture : public std::false_type {};
+
+template<typename R>
+struct IsFuture<Future<R>> : public std::true_type {};
+
+template<typename ... Futures>
+using EnableIfFutures = typename std::enable_if<
+    std::conjunction<IsFuture<typename std::decay<Futures>::type>...>::value>::type;
+
+struct FutureAccess
+{
+    template<typename R>
+    static SharedStateBase* State(Future<R> const& f) noexcept
+    {
+        return f.state_.get();
+    }
+
+    template<typename R>
+    static Future<R> Make(SharedState<R>* p) noexcept
+    {
+        return Future<R>(typename SharedState<R>::Ptr(p));
+    }
+};
+
+template<typename R, typename Fn>
+Future<typename std::invoke_result<typename std::decay<Fn>::type, Future<R>>::type>
+Then(typename SharedState<R>::Ptr state, ELaunch launch, Fn&& fn)
+{
+    using ResultType = typename std::invoke_result<typename std::decay<Fn>::type, Future<R>>::type;
+
+    PackagedTask<ResultType(Future<R>)> pt(std::forward<Fn>(fn));
+    Future<ResultType> f(pt.GetFuture());
+
+    // The continuation becomes a fiber only where a dispatcher is sure to
+    // get to it: on a thread that is running fibers, or on the scheduler of
+    // the thread that called Then(), which runs it once that thread waits.
+    // On a plain thread, or the main context of another scheduler, it runs
+    // inline on the thread that made the state ready. origin is compared,
+    // never used, so it may be gone by then.
+    Context* consumer = Context::ActiveIfAny();
+    Scheduler* origin = nullptr != consumer ? consumer->GetScheduler() : nullptr;
+
+    // state owns the continuation, so only a raw pointer is captured
+    // the state is kept alive by its producer while continuations run
+    SharedState<R>* raw = state.get();
+    raw->AddContinuation([launch, raw, origin, pt = std::move(pt)]() mutable
+    {
+        Context* active = Context::ActiveIfAny();
+        if (nullptr != active && (active->IsContext(EType::MainContext) == false || active->GetScheduler() == origin))
+        {
+            lutask::Fiber(launch, std::move(pt), FutureAccess::Make<R>(raw)).Detach();
+        }
+        else
+        {
+            pt(FutureAccess::Make<R>(raw));
+        }
+    });
+    return f;
+}
+
+template<typename Sequence>
+struct WhenAllBlock
+{
+    Promise<Sequence> promise_;
+    Sequence futures_;
+    std::atomic_size_t remaining_;
+
+    explicit WhenAllBlock(Sequence&& futures, std::size_t count)
+        : futures_(std::move(futures)), remaining_(count) {}
+
+    void Complete()
+    {
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            promise_.SetValue(std::move(futures_));
+        }
+    }
+};
+
+template<typename Sequence>
+struct WhenAnyBlock
+{
+    Promise<WhenAnyResult<Sequence>> promise_;
+    Sequence futures_;
+    std::atomic_bool done_{ false };
+
+    explicit WhenAnyBlock(Sequence&& futures)
+        : futures_(std::move(futures)) {}
+
+    void Complete(std::size_t index)
+    {
+        if (done_.exchange(true, std::memory_order_acq_rel) == false)
+        {
+            WhenAnyResult<Sequence> result;
+            result.Index = index;
+            result.Futures = std::move(futures_);
+            promise_.SetValue(std::move(result));
+        }
+    }
+};
+
+template<typename Tuple, std::size_t ... I>
+std::array<SharedStateBase*, sizeof...(I)> CollectStates(Tuple const& futures, std::index_sequence<I...>)
+{
+    std::array<SharedStateBase*, sizeof...(I)> states{ { FutureAccess::State(std::get<I>(futures))... } };
+    for (SharedStateBase* state : states)
+    {
+        if (nullptr == state)
+        {
+            throw lutask::FutureUninitialized();
+        }
+    }
+    return states;
+}
+
+template<typename R>
+std::vector<SharedStateBase*> CollectStates(std::vector<Future<R>> const& futures)
+{
+    std::vector<SharedStateBase*> states;
+    states.reserve(futures.size());
+    for (auto const& f : futures)
+    {
+        if (f.IsValid() == false)
+        {
+            throw lutask::FutureUninitialized();
+        }
+        states.push_back(FutureAccess::State(f));
+    }
+    return states;
+}
+
+// states are collected before any continuation is registered,
+// the last one to complete moves the futures out of the block
+template<typename Sequence, typename States>
+Future<Sequence> WhenAll(Sequence&& futures, States const& states)
+{
+    auto block = std::make_shared<WhenAllBlock<Sequence>>(std::move(futures), states.size());
+    Future<Sequence> f(block->promise_.GetFuture());
+
+    if (states.empty())
+    {
+        block->promise_.SetValue(std::move(block->futures_));
+        return f;
+    }
+
+    for (SharedStateBase* state : states)
+    {
+        state->AddContinuation([block]() { block->Complete(); });
+    }
+    return f;
+}
+
+template<typename Sequence, typename States>
+Future<WhenAnyResult<Sequence>> WhenAny(Sequence&& futures, States const& states)
+{
+    auto block = std::make_shared<WhenAnyBlock<Sequence>>(std::move(futures));
+    Future<WhenAnyResult<Sequence>> f(block->promise_.GetFuture());
+
+    if (states.empty())
+    {
+        block->promise_.SetValue(WhenAnyResult<Sequence>{});
+        return f;
+    }
+
+    for (std::size_t i = 0; i < states.size(); ++i)
+    {
+        states[i]->AddContinuation([block, i]() { block->Complete(i); });
+    }
+    return f;
+}
+
+}
+
+template<typename InputIt>
+Future<std::vector<typename std::iterator_traits<InputIt>::value_type>> WhenAll(InputIt first, InputIt last)
+{
+    using Sequence = std::vector<typename std::iterator_traits<InputIt>::value_type>;
+
+    Sequence futures{ std::make_move_iterator(first), std::make_move_iterator(last) };
+    auto states = detail::CollectStates(futures);
+    return detail::WhenAll(std::move(futures), states);
+}
+
+template<typename ... Futures, typename = detail::EnableIfFutures<Futures...>>
+Future<std::tuple<typename std::decay<Futures>::type...>> WhenAll(Futures&& ... futures)
+{
+    using Sequence = std::tuple<typename std::decay<Futures>::type...>;
+
+    Sequence seq{ std::forward<Futures>(futures)... };
+    auto states = detail::CollectStates(seq, std::index_sequence_for<Futures...>{});
+    return detail::WhenAll(std::move(seq), states);
+}
+
+template<typename InputIt>
+Future<WhenAnyResult<std::vector<typename std::iterator_traits<InputIt>::value_type>>> WhenAny(InputIt first, InputIt last)
+{
+    using Sequence = std::vector<typename std::iterator_traits<InputIt>::value_type>;
+
+    Sequence futures{ std::make_move_iterator(first), std::make_move_iterator(last) };
+    auto states = detail::CollectStates(futures);
+    return detail::WhenAny(std::move(futures), states);
+}
+
+template<typename ... Futures, typename = detail::EnableIfFutures<Futures...>>
+Future<WhenAnyResult<std::tuple<typename std::decay<Futures>::type...>>> WhenAny(Futures&& ... futures)
+{
+    using Sequence = std::tuple<typename std::decay<Futures>::type...>;
+
+    Sequence seq{ std::forward<Futures>(futures)... };
+    auto states = detail::CollectStates(seq, std::index_sequence_for<Futures...>{});
+    return detail::WhenAny(std::move(seq), states);
+}
+
+}
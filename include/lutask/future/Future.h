@@ -1,11 +1,31 @@
 #pragma once
 
+#include <type_traits>
 #include <lutask/Exceptions.h>
+#include <lutask/LaunchPolicy.h>
 #include <lutask/future/SharedState.h>
 
 namespace lutask
 {
 
+template<typename Signature>
+struct PackagedTask;
+
+template<typename R>
+struct PromiseBase;
+
+template<typename R>
+class Future;
+
+namespace detail
+{
+    struct FutureAccess;
+
+    template<typename R, typename Fn>
+    Future<typename std::invoke_result<typename std::decay<Fn>::type, Future<R>>::type>
+    Then(typename SharedState<R>::Ptr state, ELaunch launch, Fn&& fn);
+}
+
 struct IFuture
 {
     virtual bool IsReady() const noexcept = 0;
@@ -72,6 +92,9 @@ private:
 
     template<typename Signature>
     friend struct PackagedTask;
+    template<typename T>
+    friend struct PromiseBase;
+    friend struct detail::FutureAccess;
 
     explicit Future(typename BaseType::SharedStatePtr const& p) noexcept
         : BaseType(p) {}
@@ -86,11 +109,32 @@ public:
     {
         if (this != &other)
         {
-            BaseType::opreator = (std::move(other));
+            BaseType::operator=(std::move(other));
         }
         return *this;
     }
 
+    // fn(Future<R>) runs in a new fiber once this future is ready,
+    // the fiber is launched on the thread that makes the state ready
+    template<typename Fn>
+    Future<typename std::invoke_result<typename std::decay<Fn>::type, Future>::type> Then(Fn&& fn)
+    {
+        return Then(ELaunch::Post, std::forward<Fn>(fn));
+    }
+
+    template<typename Fn>
+    Future<typename std::invoke_result<typename std::decay<Fn>::type, Future>::type> Then(ELaunch launch, Fn&& fn)
+    {
+        if (BaseType::IsValid() == false)
+        {
+            throw lutask::FutureUninitialized();
+        }
+
+        typename BaseType::SharedStatePtr temp{};
+        temp.swap(BaseType::state_);
+        return detail::Then<R>(std::move(temp), launch, std::forward<Fn>(fn));
+    }
+
     R Get() 
     {
         if (BaseType::IsValid() == false)
@@ -115,6 +159,9 @@ private:
 
     template<typename Signature>
     friend struct PackagedTask;
+    template<typename T>
+    friend struct PromiseBase;
+    friend struct detail::FutureAccess;
 
     explicit Future(typename BaseType::SharedStatePtr const& p) noexcept
         : BaseType(p) {}
@@ -134,6 +181,25 @@ public:
         return *this;
     }
 
+    template<typename Fn>
+    Future<typename std::invoke_result<typename std::decay<Fn>::type, Future>::type> Then(Fn&& fn)
+    {
+        return Then(ELaunch::Post, std::forward<Fn>(fn));
+    }
+
+    template<typename Fn>
+    Future<typename std::invoke_result<typename std::decay<Fn>::type, Future>::type> Then(ELaunch launch, Fn&& fn)
+    {
+        if (BaseType::IsValid() == false)
+        {
+            throw lutask::FutureUninitialized();
+        }
+
+        typename BaseType::SharedStatePtr temp{};
+        temp.swap(BaseType::state_);
+        return detail::Then<void>(std::move(temp), launch, std::forward<Fn>(fn));
+    }
+
     void Get()
     {
         if (BaseType::IsValid() == false)
@@ -149,4 +215,6 @@ public:
     using BaseType::IsValid;
     using BaseType::GetExceptionPtr;
 };
-}
\ No newline at end of file
+}
+
+#include <lutask/future/Continuation.h>
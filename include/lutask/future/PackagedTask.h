@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <lutask/future/Future.h>
 #include <lutask/future/TaskObject.h>
 
@@ -17,13 +18,45 @@ private:
 public:
     template<typename Fn>
     PackagedTask(Fn&& fn)
+        : PackagedTask(std::allocator_arg, std::allocator<PackagedTask>(), std::forward<Fn>(fn))
+    {}
+
+    // the task object, which is also the shared state, comes from alloc
+    template<typename Fn, typename Allocator>
+    PackagedTask(std::allocator_arg_t, Allocator const& alloc, Fn&& fn)
     {
-        typedef TaskObject<typename std::decay<Fn>::type, R, Args...> ObjectType;
+        typedef TaskObject<typename std::decay<Fn>::type, Allocator, R, Args...> ObjectType;
+        typedef std::allocator_traits<typename ObjectType::AllocatorType> TraitsType;
 
-        task_.reset(new ObjectType(std::forward<Fn>(fn)));
+        typename ObjectType::AllocatorType a{ alloc };
+        ObjectType* p = TraitsType::allocate(a, 1);
+        try
+        {
+            TraitsType::construct(a, p, a, std::forward<Fn>(fn));
+        }
+        catch (...)
+        {
+            TraitsType::deallocate(a, p, 1);
+            throw;
+        }
+        task_.reset(p);
     }
 
-    ~PackagedTask() = default;
+    // a task dropped without running, a continuation that never got to run
+    // included, leaves its future with BrokenPromise instead of waiting forever
+    ~PackagedTask()
+    {
+        if (nullptr != task_.get() && task_->IsReady() == false)
+        {
+            try
+            {
+                task_->SetException(std::make_exception_ptr(lutask::BrokenPromise()));
+            }
+            catch (...)
+            {
+            }
+        }
+    }
 
 
     PackagedTask(PackagedTask const&) = delete;
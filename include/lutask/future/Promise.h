@@ -0,0 +1,144 @@
+#pragma once
+
+#include <memory>
+#include <lutask/Exceptions.h>
+#include <lutask/future/Future.h>
+
+namespace lutask
+{
+
+template<typename R>
+struct PromiseBase
+{
+    using SharedStatePtr = typename SharedState<R>::Ptr;
+
+    SharedStatePtr state_;
+    bool retrieved_ = false;
+
+    PromiseBase() : state_(new SharedState<R>()) {}
+
+    template<typename Allocator>
+    PromiseBase(std::allocator_arg_t, Allocator const& alloc)
+        : state_(SharedStateObject<R, Allocator>::Create(alloc)) {}
+    PromiseBase(PromiseBase const&) = delete;
+    PromiseBase(PromiseBase&& other) noexcept
+        : state_(std::move(other.state_))
+        , retrieved_(other.retrieved_)
+    {}
+
+    ~PromiseBase()
+    {
+        if (nullptr != state_.get() && state_->IsReady() == false)
+        {
+            try
+            {
+                state_->SetException(std::make_exception_ptr(lutask::BrokenPromise()));
+            }
+            catch (...)
+            {
+            }
+        }
+    }
+
+    PromiseBase& operator=(PromiseBase const&) = delete;
+    PromiseBase& operator=(PromiseBase&& other) noexcept
+    {
+        if (this != &other)
+        {
+            PromiseBase tmp(std::move(other));
+            state_.swap(tmp.state_);
+            std::swap(retrieved_, tmp.retrieved_);
+        }
+        return *this;
+    }
+
+    Future<R> GetFuture()
+    {
+        if (nullptr == state_.get())
+        {
+            throw lutask::PromiseUninitialized();
+        }
+        if (retrieved_)
+        {
+            throw lutask::TaskAlreadyRetrived();
+        }
+        retrieved_ = true;
+        return Future<R>(state_);
+    }
+
+    void SetException(std::exception_ptr except)
+    {
+        if (nullptr == state_.get())
+        {
+            throw lutask::PromiseUninitialized();
+        }
+        state_->SetException(except);
+    }
+};
+
+template<typename R>
+class Promise : private PromiseBase<R>
+{
+private:
+    using BaseType = PromiseBase<R>;
+
+public:
+    Promise() = default;
+    Promise(Promise&& other) noexcept = default;
+
+    template<typename Allocator>
+    Promise(std::allocator_arg_t, Allocator const& alloc)
+        : BaseType(std::allocator_arg, alloc) {}
+    Promise& operator=(Promise&& other) noexcept = default;
+
+    void SetValue(R const& value)
+    {
+        if (nullptr == BaseType::state_.get())
+        {
+            throw lutask::PromiseUninitialized();
+        }
+        BaseType::state_->SetValue(value);
+    }
+
+    void SetValue(R&& value)
+    {
+        if (nullptr == BaseType::state_.get())
+        {
+            throw lutask::PromiseUninitialized();
+        }
+        BaseType::state_->SetValue(std::move(value));
+    }
+
+    using BaseType::GetFuture;
+    using BaseType::SetException;
+};
+
+template<>
+class Promise<void> : private PromiseBase<void>
+{
+private:
+    using BaseType = PromiseBase<void>;
+
+public:
+    Promise() = default;
+    Promise(Promise&& other) noexcept = default;
+
+    template<typename Allocator>
+    Promise(std::allocator_arg_t, Allocator const& alloc)
+        : BaseType(std::allocator_arg, alloc) {}
+    Promise& operator=(Promise&& other) noexcept = default;
+
+    void SetValue()
+    {
+        if (nullptr == BaseType::state_.get())
+        {
+            throw lutask::PromiseUninitialized();
+        }
+        BaseType::state_->SetValue();
+    }
+
+    using BaseType::GetFuture;
+    using BaseType::SetException;
+};
+
+}
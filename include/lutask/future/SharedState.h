@@ -1,65 +1,196 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <mutex>
 #include <memory>
+#include <condition_variable>
 #include <lutask/Exceptions.h>
+#include <lutask/Context.h>
+#include <lutask/WaitQueue.h>
 #include <lutask/smart_ptr/intrusive_ptr.h>
 
 namespace lutask
 {
 
+namespace detail
+{
+// callback run once the state becomes ready, on the thread that made it ready
+struct Continuation
+{
+    Continuation* next_{ nullptr };
+
+    virtual ~Continuation() = default;
+    virtual void Run() noexcept = 0;
+};
+
+template<typename Fn>
+struct ContinuationObject final : public Continuation
+{
+    Fn fn_;
+
+    template<typename F>
+    explicit ContinuationObject(F&& fn) : fn_(std::forward<F>(fn)) {}
+
+    void Run() noexcept override final { fn_(); }
+};
+}
+
 class SharedStateBase
 {
 private:
     std::atomic_size_t useCount_ = 0;
+    // threads without a scheduler block on waiters_, any other context only
+    // suspends itself, so its thread keeps running the fibers that may set it
     mutable std::condition_variable waiters_{};
+    mutable WaitQueue fiberWaiters_{};
+    detail::Continuation* continuations_{ nullptr };
+
+    static void RunContinuations(detail::Continuation* head) noexcept
+    {
+        // registered last-in-first-out, run them in registration order
+        detail::Continuation* ordered = nullptr;
+        while (nullptr != head)
+        {
+            detail::Continuation* next = head->next_;
+            head->next_ = ordered;
+            ordered = head;
+            head = next;
+        }
+
+        while (nullptr != ordered)
+        {
+            detail::Continuation* next = ordered->next_;
+            ordered->Run();
+            delete ordered;
+            ordered = next;
+        }
+    }
 
 protected:
+    // Empty -> Writing -> Ready, Waiting is or'ed in by anyone who has to be notified.
+    // mtx_ is only taken once Waiting is set, so an uncontended set/get is two atomics
+    enum EStatus : std::uint32_t
+    {
+        Empty = 0,
+        Writing = 1 << 0,
+        Ready = 1 << 1,
+        Waiting = 1 << 2
+    };
+
     mutable std::mutex mtx_;
-    bool ready_ = false;
+    mutable std::atomic_uint32_t status_{ Empty };
     std::exception_ptr except_{};
 
-    void MarkReadyAndNotify(std::unique_lock<std::mutex>& lk) noexcept
+    // only one producer may store a result
+    void BeginSet()
     {
-        assert(lk.owns_lock());
-        ready_ = true;
+        if (status_.fetch_or(Writing, std::memory_order_acquire) & Writing)
+        {
+            throw lutask::TaskAlreadySatisfied();
+        }
+    }
+
+    void AbortSet() noexcept
+    {
+        status_.fetch_and(~static_cast<std::uint32_t>(Writing), std::memory_order_release);
+    }
+
+    // called once the last reference is gone, states built by an allocator override it
+    virtual void DeallocateFuture() noexcept
+    {
+        delete this;
+    }
+
+    void MarkReadyAndNotify() noexcept
+    {
+        // Writing is held so Ready is still clear, fetch_add is a single xadd
+        // and the release publishes the result to the lock-free readers
+        if (0 == (status_.fetch_add(Ready, std::memory_order_acq_rel) & Waiting))
+        {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lk(mtx_);
+        fiberWaiters_.NotifyAll();
+        detail::Continuation* continuations = continuations_;
+        continuations_ = nullptr;
         lk.unlock();
         waiters_.notify_all();
+        RunContinuations(continuations);
     }
 
-    void SetException(std::exception_ptr except, std::unique_lock<std::mutex>& lk)
+    void Wait() const
     {
-        assert(lk.owns_lock());
-        if (ready_ == true)
+        if (IsReady())
         {
-            throw lutask::TaskAlreadySatisfied();
+            return;
+        }
+
+        std::unique_lock<std::mutex> lk(mtx_);
+        // a thread that never ran a fiber gets no scheduler just for this
+        Context* activeCtx = Context::ActiveIfAny();
+        // setting Waiting and testing Ready is one step, a concurrent
+        // MarkReadyAndNotify either sees Waiting or is seen here
+        while (0 == (status_.fetch_or(Waiting, std::memory_order_acq_rel) & Ready))
+        {
+            if (nullptr != activeCtx && activeCtx->IsContext(EType::DispatcherContext) == false)
+            {
+                // lk is released once the fiber is switched out
+                fiberWaiters_.SuspendAndWait(lk, activeCtx);
+                lk.lock();
+            }
+            else
+            {
+                waiters_.wait(lk);
+            }
         }
-        except_ = except;
-        MarkReadyAndNotify(lk);
     }
 
-    void SetException(std::exception_ptr except)
+public:
+
+    SharedStateBase() = default;
+    virtual ~SharedStateBase()
     {
-        std::unique_lock<std::mutex> lk(mtx_);
-        SetException(except, lk);
+        // never became ready, nobody will run them
+        while (nullptr != continuations_)
+        {
+            detail::Continuation* next = continuations_->next_;
+            delete continuations_;
+            continuations_ = next;
+        }
     }
 
-    std::exception_ptr GetExceptionPtr(std::unique_lock<std::mutex>& lk)
+    void SetException(std::exception_ptr except)
     {
-        assert(lk.owns_lock());
-        return except_;
+        BeginSet();
+        except_ = except;
+        MarkReadyAndNotify();
     }
 
-    void Wait(std::unique_lock<std::mutex>& lk) const
+    std::exception_ptr GetExceptionPtr()
     {
-        assert(lk.owns_lock());
-        waiters_.wait(lk, [this]() { return ready_; });
+        Wait();
+        return except_;
     }
 
-public:
+    // fn runs right away if the state is ready already, otherwise on the
+    // thread that makes it ready; it must not block
+    template<typename Fn>
+    void AddContinuation(Fn&& fn)
+    {
+        detail::Continuation* c = new detail::ContinuationObject<typename std::decay<Fn>::type>(std::forward<Fn>(fn));
 
-    SharedStateBase() = default;
-    virtual ~SharedStateBase() = default;
+        std::unique_lock<std::mutex> lk(mtx_);
+        if (status_.fetch_or(Waiting, std::memory_order_acq_rel) & Ready)
+        {
+            lk.unlock();
+            RunContinuations(c);
+            return;
+        }
+        c->next_ = continuations_;
+        continuations_ = c;
+    }
 
     friend inline void intrusive_ptr_add_ref(SharedStateBase* p) noexcept
     {
@@ -71,11 +202,14 @@ public:
         if (1 == p->useCount_.fetch_sub(1, std::memory_order_release))
         {
             std::atomic_thread_fence(std::memory_order_acquire);
-            //p->~p();
+            p->DeallocateFuture();
         }
     }
 
-    bool IsReady() const noexcept { return ready_; }
+    bool IsReady() const noexcept
+    {
+        return 0 != (status_.load(std::memory_order_acquire) & Ready);
+    }
 };
 
 template<typename R>
@@ -88,7 +222,7 @@ public:
     SharedState() = default;
     virtual ~SharedState()
     {
-        if (ready_ && !except_)
+        if (IsReady() && !except_)
         {
             (reinterpret_cast<R*>(std::addressof(storage_)))->~R();
         }
@@ -99,31 +233,37 @@ public:
 
     void SetValue(R const& value)
     {
-        std::unique_lock<std::mutex> lk(mtx_);
-        if (ready_)
+        BeginSet();
+        try
         {
-            throw lutask::TaskAlreadySatisfied();
+            ::new (static_cast<void*>(std::addressof(storage_))) R(value);
+        }
+        catch (...)
+        {
+            AbortSet();
+            throw;
         }
-
-        ::new (static_cast<void*>(std::addressof(storage_))) R(value);
         MarkReadyAndNotify();
     }
 
     void SetValue(R&& value)
     {
-        std::unique_lock<std::mutex> lk(mtx_);
-        if (ready_)
+        BeginSet();
+        try
         {
-            throw lutask::TaskAlreadySatisfied();
+            ::new (static_cast<void*>(std::addressof(storage_))) R(std::move(value));
         }
-        ::new (static_cast<void*>(std::addressof(storage_))) R(std::move(value));
-        MarkReadyAndNotify(lk);
+        catch (...)
+        {
+            AbortSet();
+            throw;
+        }
+        MarkReadyAndNotify();
     }
 
     R& Get()
     {
-        std::unique_lock<std::mutex> lk(mtx_);
-        Wait(lk);
+        Wait();
         if (except_)
         {
             std::rethrow_exception(except_);
@@ -148,19 +288,13 @@ public:
 
     void SetValue()
     {
-        std::unique_lock<std::mutex> lk(mtx_);
-        if (ready_)
-        {
-            throw lutask::TaskAlreadySatisfied();
-        }
-
-        MarkReadyAndNotify(lk);
+        BeginSet();
+        MarkReadyAndNotify();
     }
 
     void Get()
     {
-        std::unique_lock<std::mutex> lk(mtx_);
-        Wait(lk);
+        Wait();
         if (except_)
         {
             std::rethrow_exception(except_);
@@ -168,4 +302,37 @@ public:
     }
 };
 
-}
\ No newline at end of file
+template<typename R, typename Allocator>
+class SharedStateObject final : public SharedState<R>
+{
+public:
+    using AllocatorType = typename std::allocator_traits<Allocator>::template rebind_alloc<SharedStateObject>;
+
+    explicit SharedStateObject(AllocatorType const& alloc) noexcept
+        : alloc_(alloc) {}
+
+    static SharedStateObject* Create(Allocator const& alloc)
+    {
+        using Traits = std::allocator_traits<AllocatorType>;
+
+        AllocatorType a{ alloc };
+        SharedStateObject* p = Traits::allocate(a, 1);
+        Traits::construct(a, p, a);
+        return p;
+    }
+
+protected:
+    void DeallocateFuture() noexcept override final
+    {
+        using Traits = std::allocator_traits<AllocatorType>;
+
+        AllocatorType a{ alloc_ };
+        Traits::destroy(a, this);
+        Traits::deallocate(a, this, 1);
+    }
+
+private:
+    AllocatorType alloc_;
+};
+
+}
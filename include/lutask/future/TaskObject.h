@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+#include <tuple>
 #include <lutask/future/SharedState.h>
 
 namespace lutask
@@ -16,11 +18,22 @@ struct TaskBase : public SharedState<R>
     virtual Ptr Reset() = 0;
 };
 
-template<typename Fn, typename R, typename ...Args>
+template<typename Fn, typename Allocator, typename R, typename ...Args>
 struct TaskObject : public TaskBase<R, Args...>
 {
-    TaskObject(Fn const& fn)
-        : fn_(fn)
+private:
+    using BaseType = TaskBase<R, Args...>;
+    using AllocatorTraits = std::allocator_traits<Allocator>;
+
+public:
+    using AllocatorType = typename AllocatorTraits::template rebind_alloc<TaskObject>;
+
+    TaskObject(AllocatorType const& alloc, Fn const& fn)
+        : BaseType{}, fn_(fn), alloc_(alloc)
+    {}
+
+    TaskObject(AllocatorType const& alloc, Fn&& fn)
+        : BaseType{}, fn_(std::move(fn)), alloc_(alloc)
     {}
 
     void Run(Args&& ...args) override final
@@ -35,19 +48,50 @@ struct TaskObject : public TaskBase<R, Args...>
         }
     }
 
-    typename TaskBase<R, Args...>::Ptr Reset() override final
+    typename BaseType::Ptr Reset() override final
     {
         //delete 
         return this;
     }
 
+protected:
+    void DeallocateFuture() noexcept override final
+    {
+        Destroy(alloc_, this);
+    }
+
 private:
     Fn fn_;
+    AllocatorType alloc_;
+
+    static void Destroy(AllocatorType const& alloc, TaskObject* p) noexcept
+    {
+        using Traits = std::allocator_traits<AllocatorType>;
+
+        AllocatorType a{ alloc };
+        Traits::destroy(a, p);
+        Traits::deallocate(a, p, 1);
+    }
 };
 
-template<typename Fn, typename ...Args>
-struct TaskObject<Fn, void, Args...> : public TaskBase<void, Args...>
+template<typename Fn, typename Allocator, typename ...Args>
+struct TaskObject<Fn, Allocator, void, Args...> : public TaskBase<void, Args...>
 {
+private:
+    using BaseType = TaskBase<void, Args...>;
+    using AllocatorTraits = std::allocator_traits<Allocator>;
+
+public:
+    using AllocatorType = typename AllocatorTraits::template rebind_alloc<TaskObject>;
+
+    TaskObject(AllocatorType const& alloc, Fn const& fn)
+        : BaseType{}, fn_(fn), alloc_(alloc)
+    {}
+
+    TaskObject(AllocatorType const& alloc, Fn&& fn)
+        : BaseType{}, fn_(std::move(fn)), alloc_(alloc)
+    {}
+
     void Run(Args&& ...args) override final
     {
         try
@@ -61,11 +105,30 @@ struct TaskObject<Fn, void, Args...> : public TaskBase<void, Args...>
         }
     }
 
-    typename TaskBase<void, Args...>::Ptr Reset() override final
+    typename BaseType::Ptr Reset() override final
     {
         //delete 
         return this;
     }
+
+protected:
+    void DeallocateFuture() noexcept override final
+    {
+        Destroy(alloc_, this);
+    }
+
+private:
+    Fn fn_;
+    AllocatorType alloc_;
+
+    static void Destroy(AllocatorType const& alloc, TaskObject* p) noexcept
+    {
+        using Traits = std::allocator_traits<AllocatorType>;
+
+        AllocatorType a{ alloc };
+        Traits::destroy(a, p);
+        Traits::deallocate(a, p, 1);
+    }
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <condition_variable>
+#include <lutask/schedule/IPolicy.h>
+#include <lutask/Context.h>
+#include <lutask/detail/IntrusiveList.h>
+
+namespace lutask{
+namespace schedule{
+
+// Earliest deadline first. Contexts with a deadline sit in a binary min-heap
+// keyed by the deadline they had when they became ready, ties in wake order;
+// the others form a best-effort FIFO behind them. The FIFO, which also holds
+// the dispatcher, gets a turn after AgingLimit heap picks in a row, so timers
+// and remote wakeups are still served while deadline work is queued.
+class EdfPolicy : public IPolicy 
+{
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+public:
+    static constexpr std::size_t AgingLimit = 16;
+
+private:
+    struct Entry
+    {
+        TimePoint       deadline;
+        std::uint64_t   seq;
+        Context*        ctx;
+    };
+
+    static std::atomic_size_t   totalMisses_;
+
+    std::vector<Entry>          heap_{};
+    detail::IntrusiveList<Context, ReadyHookTag> bestEffort_{};
+    std::uint64_t               seq_{ 0 };
+    std::size_t                 passedOver_{ 0 };
+    std::atomic_size_t          misses_{ 0 };
+
+    std::mutex                  mtx_{};
+    std::condition_variable     cnd_{};
+    bool                        flag_{ false };
+
+    static bool Earlier(Entry const& l, Entry const& r) noexcept
+    {
+        return l.deadline < r.deadline || (l.deadline == r.deadline && l.seq < r.seq);
+    }
+
+    void Place(std::size_t index, Entry const& entry) noexcept;
+    void SiftUp(std::size_t index) noexcept;
+    void SiftDown(std::size_t index) noexcept;
+    Entry RemoveAt(std::size_t index) noexcept;
+
+public:
+    EdfPolicy() = default;
+
+    EdfPolicy(EdfPolicy const&) = delete;
+    EdfPolicy& operator=(EdfPolicy const&) = delete;
+
+    virtual void Awakened(Context* ctx) noexcept override final;
+    virtual Context* PickNext() noexcept override final;
+    virtual bool HasReadyFibers() const noexcept override final;
+    virtual void SuspendUntil(TimePoint const&) noexcept override final;
+    virtual void Notify() noexcept override final;
+    virtual void PriorityChanged(Context* ctx) noexcept override final;
+
+    // picks of a fiber whose deadline had already passed, may be read from any thread
+    std::size_t DeadlineMisses() const noexcept { return misses_.load(std::memory_order_relaxed); }
+    static std::size_t TotalDeadlineMisses() noexcept { return totalMisses_.load(std::memory_order_relaxed); }
+};
+
+}}
@@ -21,6 +21,19 @@ public:
     virtual bool HasReadyFibers() const noexcept = 0;
     virtual void SuspendUntil(TimePoint const&) noexcept = 0;
     virtual void Notify() noexcept = 0;
+
+    // ELaunch::Async fibers, free to run on any thread that shares them; by
+    // default they are attached to the spawning thread and run like a post
+    virtual void AwakenedAsync(Context*) noexcept;
+    // a batch of fresh fibers, by default one call of the single version each;
+    // policies that wake other threads override them to wake once per batch
+    virtual void AwakenedBatch(Context* const* ctxs, std::size_t count) noexcept;
+    virtual void AwakenedAsyncBatch(Context* const* ctxs, std::size_t count) noexcept;
+    // the priority or deadline of a context changed, it may be in the ready queue already
+    virtual void PriorityChanged(Context*) noexcept;
+    // true if Awakened detaches every unpinned context to share it with other
+    // threads; fresh batches are then handed over without being attached
+    virtual bool DetachesAwakened() const noexcept;
 };
 
 }}
\ No newline at end of file
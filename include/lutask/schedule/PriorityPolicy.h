@@ -0,0 +1,49 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <lutask/schedule/IPolicy.h>
+#include <lutask/Context.h>
+#include <lutask/detail/IntrusiveList.h>
+
+namespace lutask{
+namespace schedule{
+
+// One FIFO band per EPriority, PickNext() serves the highest non-empty band.
+// A bitmap tracks the non-empty bands; a band passed over AgingLimit times in a
+// row while holding ready fibers gets the next turn, so bulk work still runs
+// under a steady stream of urgent fibers.
+class PriorityPolicy : public IPolicy 
+{
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+public:
+    static constexpr std::size_t BandCount = static_cast<std::size_t>(EPriority::Critical) + 1;
+    static constexpr std::size_t AgingLimit = 16;
+
+private:
+    detail::IntrusiveList<Context, ReadyHookTag> bands_[BandCount];
+    std::size_t                 passedOver_[BandCount]{};
+    unsigned int                bitmap_{ 0 };
+
+    std::mutex                  mtx_{};
+    std::condition_variable     cnd_{};
+    bool                        flag_{ false };
+
+    void Unlink(Context* ctx) noexcept;
+
+public:
+    PriorityPolicy() = default;
+
+    PriorityPolicy(PriorityPolicy const&) = delete;
+    PriorityPolicy& operator=(PriorityPolicy const&) = delete;
+
+    virtual void Awakened(Context* ctx) noexcept override final;
+    virtual Context* PickNext() noexcept override final;
+    virtual bool HasReadyFibers() const noexcept override final;
+    virtual void SuspendUntil(TimePoint const&) noexcept override final;
+    virtual void Notify() noexcept override final;
+    virtual void PriorityChanged(Context* ctx) noexcept override final;
+};
+
+}}
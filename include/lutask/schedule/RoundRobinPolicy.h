@@ -2,6 +2,7 @@
 
 #include <mutex>
 #include <queue>
+#include <condition_variable>
 #include <lutask/schedule/IPolicy.h>
 #include <lutask/Context.h>
 
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <mutex>
-#include <queue>
+#include <condition_variable>
 #include <lutask/schedule/IPolicy.h>
 #include <lutask/Context.h>
+#include <lutask/detail/IntrusiveList.h>
+#include <lutask/detail/MPMCQueue.h>
 
 namespace lutask{
 namespace schedule{
@@ -12,10 +14,12 @@ class SharedWorkPolicy : public IPolicy
 {
     using TimePoint = std::chrono::steady_clock::time_point;
 
-    static std::queue<Context*> readyQueue_;
+    static detail::MPMCQueue<Context*> readyQueue_;
     static std::mutex           rqueueMutex_;
 
-    std::queue<Context*>    localQueue_;
+    // pinned contexts, linked through their ready hook so a round trip of
+    // the main and dispatcher contexts never allocates
+    detail::IntrusiveList<Context, ReadyHookTag> localQueue_;
     std::mutex                  mtx_;
     std::condition_variable     cnd_;
     bool                        flag_ = false;
@@ -34,8 +38,11 @@ public:
     virtual bool HasReadyFibers() const noexcept override final;
     virtual void SuspendUntil(TimePoint const&) noexcept override final;
     virtual void Notify() noexcept override final;
+    // into the shared queue, whichever SharedWorkPolicy thread is free runs it
+    virtual void AwakenedAsync(Context* ctx) noexcept override final;
+    virtual bool DetachesAwakened() const noexcept override final { return true; }
 
-    static void AwakenedAsync(Context* ctx) noexcept;
+    static void EnqueueShared(Context* ctx) noexcept;
 };
 
 }}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <condition_variable>
+#include <lutask/schedule/IPolicy.h>
+#include <lutask/detail/ChaseLevDeque.h>
+#include <lutask/Context.h>
+
+namespace lutask{
+namespace schedule{
+
+class WorkStealingPolicy;
+
+// The workers that steal from and wake each other; workers of different
+// groups never see each other's fibers. A ThreadPool makes one for its
+// workers, threads that set up a WorkStealingPolicy without naming a group
+// share Default().
+class WorkStealingGroup
+{
+public:
+    static constexpr std::size_t MaxWorkers = 256;
+
+    WorkStealingGroup() = default;
+
+    WorkStealingGroup(WorkStealingGroup const&) = delete;
+    WorkStealingGroup& operator=(WorkStealingGroup const&) = delete;
+
+    static std::shared_ptr<WorkStealingGroup> const& Default();
+
+private:
+    friend class WorkStealingPolicy;
+
+    // MaxWorkers if every slot is taken
+    std::size_t Register(WorkStealingPolicy* worker) noexcept;
+    void Unregister(std::size_t id) noexcept;
+
+    std::atomic<WorkStealingPolicy*> workers_[MaxWorkers]{};
+    // only bounds the scans, it never shrinks
+    std::atomic_size_t               workerCount_{ 0 };
+    std::atomic_size_t               sleepingCount_{ 0 };
+};
+
+class WorkStealingPolicy : public IPolicy 
+{
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    static constexpr std::size_t MaxWorkers = WorkStealingGroup::MaxWorkers;
+    static constexpr std::size_t PinnedInterval = 16;
+    static constexpr std::size_t OldestInterval = 8;
+
+    std::shared_ptr<WorkStealingGroup>      group_;
+    // MaxWorkers if every slot of the group was taken
+    std::size_t                             id_;
+    // NUMA node of the thread that made the policy, stealing prefers its peers
+    std::size_t                             node_;
+    detail::ChaseLevDeque<Context>          deque_{};
+    std::queue<Context*>                    localQueue_{};
+    std::minstd_rand                        rng_;
+    std::size_t                             pickCount_{ 0 };
+
+    std::mutex                  mtx_{};
+    std::condition_variable     cnd_{};
+    bool                        flag_{ false };
+    bool                        suspend_;
+    std::atomic_bool            sleeping_{ false };
+
+    Context* Steal() noexcept;
+    Context* StealFrom(std::size_t count, bool sameNode) noexcept;
+    // wakes up to count sleeping workers
+    void NotifyIdle(std::size_t count = 1) noexcept;
+
+public:
+    // joins WorkStealingGroup::Default()
+    explicit WorkStealingPolicy(bool suspend = false);
+    explicit WorkStealingPolicy(std::shared_ptr<WorkStealingGroup> group, bool suspend = false);
+    ~WorkStealingPolicy();
+
+    WorkStealingPolicy(WorkStealingPolicy const&) = delete;
+    WorkStealingPolicy(WorkStealingPolicy&&) = delete;
+
+    WorkStealingPolicy& operator=(WorkStealingPolicy const&) = delete;
+    WorkStealingPolicy& operator=(WorkStealingPolicy&&) = delete;
+
+    virtual void Awakened(Context* ctx) noexcept override final;
+    virtual Context* PickNext() noexcept override final;
+    virtual bool HasReadyFibers() const noexcept override final;
+    virtual void SuspendUntil(TimePoint const&) noexcept override final;
+    virtual void Notify() noexcept override final;
+    virtual void AwakenedAsync(Context* ctx) noexcept override final;
+    virtual void AwakenedBatch(Context* const* ctxs, std::size_t count) noexcept override final;
+    virtual void AwakenedAsyncBatch(Context* const* ctxs, std::size_t count) noexcept override final;
+    virtual bool DetachesAwakened() const noexcept override final { return true; }
+};
+
+}}
@@ -134,6 +134,11 @@ Context* Context::Active() noexcept
     return ContextInitializer::active_;
 }
 
+Context* Context::ActiveIfAny() noexcept
+{
+    return ContextInitializer::active_;
+}
+
 void Context::ChangeActive(Context* ctx) noexcept
 {
     ContextInitializer::active_ = ctx;
@@ -148,9 +153,12 @@ void Context::Join()
 {
     Context* activeCtx = Context::Active();
 
+    // the flag is read under the same lock Terminate() sets it with,
+    // a joiner on another thread can not slip in after the last notify
+    std::unique_lock<detail::Spinlock> lk(splk_);
     if (terminated_ == false) 
     {
-        waitList_.SuspendAndWait(activeCtx);
+        waitList_.SuspendAndWait(lk, activeCtx);
 
         assert(Context::Active() == activeCtx);
     }
@@ -158,6 +166,7 @@ void Context::Join()
 
 void Context::Resume() noexcept
 {
+    LUTASK_TRACE_EVENT(Resume, this, scheduler_);
     Context* prev = this;
     std::swap(ContextInitializer::active_, prev);
     std::move(c_).ResumeWith([prev](lutask::context::FiberContext&& c)
@@ -167,8 +176,12 @@ void Context::Resume() noexcept
         });
 }
 
-void Context::Resume(std::unique_lock<std::mutex>& lk) noexcept
+// lk is released on the other side of the switch, once the suspended
+// context can be resumed safely
+template<typename Lock>
+void Context::ResumeUnlocking_(Lock& lk) noexcept
 {
+    LUTASK_TRACE_EVENT(Resume, this, scheduler_);
     Context* prev = this;
     std::swap(ContextInitializer::active_, prev);
     std::move(c_).ResumeWith([prev, &lk](lutask::context::FiberContext&& c)
@@ -179,15 +192,26 @@ void Context::Resume(std::unique_lock<std::mutex>& lk) noexcept
         });
 }
 
+void Context::Resume(std::unique_lock<std::mutex>& lk) noexcept
+{
+    ResumeUnlocking_(lk);
+}
+
+void Context::Resume(std::unique_lock<detail::Spinlock>& lk) noexcept
+{
+    ResumeUnlocking_(lk);
+}
+
 
 void Context::Resume(Context* readyCtx) noexcept
 {
+    LUTASK_TRACE_EVENT(Resume, this, scheduler_);
     Context* prev = this;
     std::swap(ContextInitializer::active_, prev);
     std::move(c_).ResumeWith([prev, readyCtx](lutask::context::FiberContext&& c)
         {
             prev->c_ = std::move(c);
-            Context::Active()->GetScheduler()->Schedule(readyCtx);
+            readyCtx->Wake();
             return lutask::context::FiberContext();
         });
 }
@@ -202,8 +226,14 @@ void Context::Suspend(std::unique_lock<std::mutex>& lk) noexcept
     scheduler_->Suspend(lk);
 }
 
+void Context::Suspend(std::unique_lock<detail::Spinlock>& lk) noexcept
+{
+    scheduler_->Suspend(lk);
+}
+
 lutask::context::FiberContext Context::SuspendWithCC() noexcept
 {
+    LUTASK_TRACE_EVENT(Resume, this, scheduler_);
     Context* prev = this;
     std::swap(ContextInitializer::active_, prev);
     return std::move(c_).ResumeWith([prev](lutask::context::FiberContext&& c)
@@ -215,9 +245,12 @@ lutask::context::FiberContext Context::SuspendWithCC() noexcept
 
 lutask::context::FiberContext Context::Terminate() noexcept
 {
-    terminated_ = true;
-    waitList_.NotifyAll();
-    assert(waitList_.IsEmpty());
+    {
+        std::unique_lock<detail::Spinlock> lk(splk_);
+        terminated_ = true;
+        waitList_.NotifyAll();
+        assert(waitList_.IsEmpty());
+    }
     return scheduler_->Terminate(this);
 }
 
@@ -238,19 +271,89 @@ bool Context::WaitUntil(std::chrono::steady_clock::time_point const& tp) noexcep
     return scheduler_->WaitUntil(this, tp);
 }
 
+bool Context::WaitUntil(std::chrono::steady_clock::time_point const& tp, std::unique_lock<std::mutex>& lk) noexcept
+{
+    assert(scheduler_ != nullptr);
+    assert(this == Active());
+    return scheduler_->WaitUntil(this, tp, lk);
+}
+
+bool Context::WaitUntil(std::chrono::steady_clock::time_point const& tp, std::unique_lock<detail::Spinlock>& lk) noexcept
+{
+    assert(scheduler_ != nullptr);
+    assert(this == Active());
+    return scheduler_->WaitUntil(this, tp, lk);
+}
+
+bool Context::ClaimWakeup(EWait by) noexcept
+{
+    EWait state = wait_.load(std::memory_order_acquire);
+    if (EWait::None == state)
+    {
+        return true;
+    }
+    return EWait::Timed == state
+        && wait_.compare_exchange_strong(state, by, std::memory_order_acq_rel);
+}
+
+void Context::SetPriority(EPriority priority) noexcept
+{
+    if (priority == priority_.exchange(priority, std::memory_order_relaxed))
+        return;
+
+    // the ready queues belong to the owning thread
+    Scheduler* owner = scheduler_;
+    if (nullptr != owner && Context::Active()->GetScheduler() == owner)
+    {
+        owner->PriorityChanged(this);
+    }
+}
+
+void Context::SetDeadline(TimePoint const& deadline) noexcept
+{
+    if (deadline == deadline_.exchange(deadline, std::memory_order_relaxed))
+        return;
+
+    Scheduler* owner = scheduler_;
+    if (nullptr != owner && Context::Active()->GetScheduler() == owner)
+    {
+        owner->PriorityChanged(this);
+    }
+}
+
 bool Context::Wake() noexcept
 {
-    assert(Context::Active() != nullptr);
+    Context* active = Context::Active();
+    assert(active != nullptr);
+
+    // the deadline of a timed wait fired first
+    if (ClaimWakeup(EWait::Notified) == false)
+    {
+        return false;
+    }
 
-    scheduler_->Schedule(this);
+    // a context on its way back to its origin has no scheduler yet
+    Scheduler* owner = nullptr != scheduler_ ? scheduler_ : originScheduler_;
+    assert(nullptr != owner);
+
+    if (active->GetScheduler() == owner && nullptr != scheduler_)
+    {
+        owner->Schedule(this);
+    }
+    else
+    {
+        // policies are single threaded, the owning dispatcher picks it up
+        owner->ScheduleRemote(this);
+    }
 
     return true;
 }
 
 void Context::Detach() noexcept
 {
-    if (policy_ == ELaunch::Async)
+    if (nullptr == scheduler_)
     {
+        // not attached yet (e.g. a fresh ELaunch::Async fiber)
         return;
     }
     assert(Context::Active() != this);
@@ -17,6 +17,8 @@ public:
 			return std::error_condition(static_cast<int>(ETaskError::AlreadySatisfied), TaskCategory());
 		case ETaskError::NoState:
 			return std::error_condition(static_cast<int>(ETaskError::NoState), TaskCategory());
+		case ETaskError::BrokenPromise:
+			return std::error_condition(static_cast<int>(ETaskError::BrokenPromise), TaskCategory());
 		default:
 			return std::error_condition(ev, *this);
 		}
@@ -37,13 +39,15 @@ public:
 			return "the state of the task already been set.";
 		case ETaskError::NoState:
 			return "Operation not permitted on an object without an associated state.";
+		case ETaskError::BrokenPromise:
+			return "the promise was destroyed before a value was set.";
 		default:
 			return "unspecified task error value";
 		}
 	}
 };
 
-std::error_category const& lutask::TaskCategory() noexcept
+std::error_category const& TaskCategory() noexcept
 {
 	static TaskErrorCategory cat;
 	return cat;
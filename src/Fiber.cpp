@@ -1,13 +1,14 @@
 #include <lutask/Fiber.h>
 #include <lutask/Scheduler.h>
 #include <lutask/Exceptions.h>
-#include <lutask/schedule/SharedWorkPolicy.h>
 
 namespace lutask
 {
 
 void Fiber::_Start() noexcept {
     Context* ctx = Context::Active();
+    ctx->GetScheduler()->CountSpawn();
+    LUTASK_TRACE_EVENT(Spawn, impl_.get(), ctx->GetScheduler());
     switch (impl_->GetType())
     {
     case ELaunch::Post:
@@ -19,15 +20,78 @@ void Fiber::_Start() noexcept {
         impl_->Resume(ctx);
         break;
     case ELaunch::Async:
-        std::cout << "## _start thread id: " << std::this_thread::get_id() << std::endl;
         impl_.get()->originScheduler_ = ctx->GetScheduler();
-        schedule::SharedWorkPolicy::AwakenedAsync(impl_.get());
+        ctx->GetScheduler()->ScheduleAsync(impl_.get());
         break;
     default:
         assert(false && "unknown launch-policy");
     }
 }
 
+void Fiber::_StartBatch(ELaunch launch, Context::Ptr* batch, std::size_t count) noexcept
+{
+    if (0 == count)
+        return;
+
+    Context* ctx = Context::Active();
+    Scheduler* scheduler = ctx->GetScheduler();
+    Context* ctxs[MaxBatch];
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        ctxs[i] = batch[i].get();
+        LUTASK_TRACE_EVENT(Spawn, ctxs[i], scheduler);
+    }
+    scheduler->CountSpawn(count);
+
+    switch (launch)
+    {
+    case ELaunch::Post:
+    case ELaunch::Dispatch:
+        scheduler->ScheduleBatch(ctxs, count);
+        break;
+    case ELaunch::Async:
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            ctxs[i]->originScheduler_ = scheduler;
+        }
+        scheduler->ScheduleAsyncBatch(ctxs, count);
+        break;
+    default:
+        assert(false && "unknown launch-policy");
+    }
+
+    // detached, the scheduler keeps them until they terminate
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        batch[i].reset();
+    }
+
+    if (ELaunch::Dispatch == launch)
+    {
+        ctx->Yield();
+    }
+}
+
+void Fiber::SetSleepQueue(ESleepQueue mode, std::chrono::steady_clock::duration tick) noexcept
+{
+    Context::Active()->GetScheduler()->SetSleepQueue(mode, tick);
+}
+
+SchedulerStats Fiber::GetSchedulerStats() noexcept
+{
+    return Context::Active()->GetScheduler()->GetStats();
+}
+
+void Fiber::EnableLatencyHistograms()
+{
+    Context::Active()->GetScheduler()->EnableLatencyHistograms();
+}
+
+SchedulerLatency Fiber::GetSchedulerLatency() noexcept
+{
+    return Context::Active()->GetScheduler()->GetLatency();
+}
+
 void Fiber::Join()
 {
     if (Context::Active() == impl_.get())
@@ -0,0 +1,147 @@
+#include <lutask/LatencyHistogram.h>
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace lutask
+{
+
+namespace
+{
+	constexpr std::uint64_t MaxValue = (std::uint64_t(1) << (LatencyHistogram::MaxExponent + 1)) - 1;
+
+	std::size_t HighestBit(std::uint64_t v) noexcept
+	{
+#if defined(_MSC_VER)
+		unsigned long index = 0;
+		_BitScanReverse64(&index, v);
+		return index;
+#else
+		return 63 - __builtin_clzll(v);
+#endif
+	}
+}
+
+std::size_t LatencyHistogram::BucketOf(std::uint64_t ns) noexcept
+{
+	if (ns < SubBuckets)
+		return static_cast<std::size_t>(ns);
+
+	ns = (std::min)(ns, MaxValue);
+	const std::size_t shift = HighestBit(ns) - SubBucketBits;
+	const std::size_t sub = static_cast<std::size_t>(ns >> shift) & (SubBuckets - 1);
+	return (shift + 1) * SubBuckets + sub;
+}
+
+std::uint64_t LatencyHistogram::LowerBound(std::size_t bucket) noexcept
+{
+	if (bucket < SubBuckets)
+		return bucket;
+
+	const std::size_t shift = bucket / SubBuckets - 1;
+	return static_cast<std::uint64_t>(SubBuckets + bucket % SubBuckets) << shift;
+}
+
+std::uint64_t LatencyHistogram::UpperBound(std::size_t bucket) noexcept
+{
+	if (bucket < SubBuckets)
+		return bucket;
+
+	const std::size_t shift = bucket / SubBuckets - 1;
+	return LowerBound(bucket) + (std::uint64_t(1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(std::uint64_t ns, std::uint64_t count) noexcept
+{
+	counts_[BucketOf(ns)] += count;
+	count_ += count;
+	sum_ += ns * count;
+	min_ = (std::min)(min_, ns);
+	max_ = (std::max)(max_, ns);
+}
+
+void LatencyHistogram::Reset() noexcept
+{
+	*this = LatencyHistogram();
+}
+
+LatencyHistogram& LatencyHistogram::operator+=(LatencyHistogram const& other) noexcept
+{
+	for (std::size_t i = 0; i < BucketCount; ++i)
+	{
+		counts_[i] += other.counts_[i];
+	}
+	count_ += other.count_;
+	sum_ += other.sum_;
+	min_ = (std::min)(min_, other.min_);
+	max_ = (std::max)(max_, other.max_);
+	return *this;
+}
+
+std::uint64_t LatencyHistogram::Percentile(double percentile) const noexcept
+{
+	if (0 == count_)
+		return 0;
+
+	const double rank = std::ceil((std::min)((std::max)(percentile, 0.0), 100.0) / 100.0 * count_);
+	const std::uint64_t target = (std::max)(static_cast<std::uint64_t>(rank), std::uint64_t(1));
+	std::uint64_t seen = 0;
+	for (std::size_t i = 0; i < BucketCount; ++i)
+	{
+		seen += counts_[i];
+		if (target <= seen)
+		{
+			// nothing recorded is above max_, the bucket may reach beyond it
+			return (std::min)(UpperBound(i), max_);
+		}
+	}
+	return max_;
+}
+
+void LatencyHistogram::WriteJson(std::ostream& out) const
+{
+	out << "{\"count\":" << count_
+		<< ",\"min_ns\":" << Min()
+		<< ",\"mean_ns\":" << static_cast<std::uint64_t>(Mean())
+		<< ",\"p50_ns\":" << Percentile(50)
+		<< ",\"p90_ns\":" << Percentile(90)
+		<< ",\"p99_ns\":" << Percentile(99)
+		<< ",\"p999_ns\":" << Percentile(99.9)
+		<< ",\"max_ns\":" << max_
+		<< ",\"buckets\":[";
+	bool first = true;
+	for (std::size_t i = 0; i < BucketCount; ++i)
+	{
+		if (0 == counts_[i])
+			continue;
+
+		out << (first ? "" : ",") << '[' << LowerBound(i) << ',' << UpperBound(i) << ',' << counts_[i] << ']';
+		first = false;
+	}
+	out << "]}";
+}
+
+namespace detail
+{
+
+LatencyHistogram AtomicHistogram::Snapshot() const noexcept
+{
+	LatencyHistogram histogram;
+	for (std::size_t i = 0; i < LatencyHistogram::BucketCount; ++i)
+	{
+		histogram.counts_[i] = counts_[i].load(std::memory_order_relaxed);
+	}
+	histogram.count_ = count_.load(std::memory_order_relaxed);
+	histogram.sum_ = sum_.load(std::memory_order_relaxed);
+	histogram.min_ = min_.load(std::memory_order_relaxed);
+	histogram.max_ = max_.load(std::memory_order_relaxed);
+	return histogram;
+}
+
+}
+
+}
@@ -0,0 +1,184 @@
+#include <lutask/Mutex.h>
+#include <lutask/Context.h>
+#include <lutask/Exceptions.h>
+#include <lutask/detail/MPMCQueue.h>
+
+namespace lutask
+{
+
+Mutex::~Mutex()
+{
+	assert(nullptr == owner_.load(std::memory_order_relaxed));
+	assert(waitQueue_.IsEmpty());
+}
+
+bool Mutex::TryAcquire(Context* ctx) noexcept
+{
+	Context* expected = nullptr;
+	if (owner_.compare_exchange_strong(expected, ctx, std::memory_order_seq_cst, std::memory_order_relaxed) == false)
+		return false;
+
+	ownerScheduler_.store(ctx->GetScheduler(), std::memory_order_relaxed);
+	return true;
+}
+
+void Mutex::Lock()
+{
+	Context* ctx = Context::Active();
+	if (ctx == owner_.load(std::memory_order_relaxed))
+	{
+		throw LockError(std::make_error_code(std::errc::resource_deadlock_would_occur),
+			"lutask: a fiber tried to lock a mutex it already owns");
+	}
+
+	if (TryAcquire(ctx))
+		return;
+
+	// an owner on another thread may be about to release it, one on this
+	// thread cannot run before we park
+	if (ctx->GetScheduler() != ownerScheduler_.load(std::memory_order_relaxed))
+	{
+		detail::Backoff backoff;
+		for (unsigned i = 0; i < SpinCount; ++i)
+		{
+			backoff.Spin();
+			if (nullptr == owner_.load(std::memory_order_relaxed) && TryAcquire(ctx))
+				return;
+		}
+	}
+
+	LockSlow(ctx, nullptr);
+}
+
+bool Mutex::TryLock()
+{
+	Context* ctx = Context::Active();
+	if (ctx == owner_.load(std::memory_order_relaxed))
+	{
+		throw LockError(std::make_error_code(std::errc::resource_deadlock_would_occur),
+			"lutask: a fiber tried to lock a mutex it already owns");
+	}
+	return TryAcquire(ctx);
+}
+
+bool Mutex::LockSlow(Context* ctx, std::chrono::steady_clock::time_point const* tp)
+{
+	std::unique_lock<detail::Spinlock> lk(splk_);
+	// announced before the last attempt, Unlock() either sees us or we see it free
+	waiting_.fetch_add(1, std::memory_order_seq_cst);
+
+	bool acquired = false;
+	for (;;)
+	{
+		// Unlock() hands over by storing the waiter as the new owner
+		if (ctx == owner_.load(std::memory_order_relaxed) || TryAcquire(ctx))
+		{
+			ownerScheduler_.store(ctx->GetScheduler(), std::memory_order_relaxed);
+			acquired = true;
+			break;
+		}
+
+		if (nullptr == tp)
+		{
+			waitQueue_.SuspendAndWait(lk, ctx);
+			lk.lock();
+		}
+		else if (waitQueue_.SuspendAndWaitUntil(lk, ctx, *tp) == false)
+		{
+			acquired = ctx == owner_.load(std::memory_order_relaxed);
+			break;
+		}
+	}
+
+	waiting_.fetch_sub(1, std::memory_order_relaxed);
+	return acquired;
+}
+
+void Mutex::Unlock()
+{
+	Context* ctx = Context::Active();
+	if (ctx != owner_.load(std::memory_order_relaxed))
+	{
+		throw LockError(std::make_error_code(std::errc::operation_not_permitted),
+			"lutask: no privilege to perform the operation");
+	}
+	Release(ctx);
+}
+
+void Mutex::Release(Context* ctx)
+{
+	if (0 == waiting_.load(std::memory_order_seq_cst))
+	{
+		owner_.store(nullptr, std::memory_order_seq_cst);
+		if (0 == waiting_.load(std::memory_order_seq_cst))
+			return;
+
+		// somebody queued up meanwhile, unless it grabbed the mutex on its own
+		// take it back and hand it over like below
+		std::unique_lock<detail::Spinlock> lk(splk_);
+		if (TryAcquire(ctx) == false)
+			return;
+
+		owner_.store(waitQueue_.NotifyOne(), std::memory_order_release);
+		return;
+	}
+
+	std::unique_lock<detail::Spinlock> lk(splk_);
+	// nullptr when the remaining waiters already timed out
+	owner_.store(waitQueue_.NotifyOne(), std::memory_order_release);
+}
+
+bool TimedMutex::TryLockUntil(std::chrono::steady_clock::time_point const& tp)
+{
+	Context* ctx = Context::Active();
+	if (TryLock())
+		return true;
+
+	if (std::chrono::steady_clock::now() >= tp)
+		return false;
+
+	return LockSlow(ctx, &tp);
+}
+
+void RecursiveMutex::Lock()
+{
+	Context* ctx = Context::Active();
+	if (ctx == mtx_.owner_.load(std::memory_order_relaxed))
+	{
+		++count_;
+		return;
+	}
+	mtx_.Lock();
+	count_ = 1;
+}
+
+bool RecursiveMutex::TryLock()
+{
+	Context* ctx = Context::Active();
+	if (ctx == mtx_.owner_.load(std::memory_order_relaxed))
+	{
+		++count_;
+		return true;
+	}
+	if (mtx_.TryAcquire(ctx) == false)
+		return false;
+
+	count_ = 1;
+	return true;
+}
+
+void RecursiveMutex::Unlock()
+{
+	Context* ctx = Context::Active();
+	if (ctx != mtx_.owner_.load(std::memory_order_relaxed))
+	{
+		throw LockError(std::make_error_code(std::errc::operation_not_permitted),
+			"lutask: no privilege to perform the operation");
+	}
+	if (0 == --count_)
+	{
+		mtx_.Release(ctx);
+	}
+}
+
+}
@@ -2,12 +2,26 @@
 
 namespace lutask
 {
+
+namespace
+{
+	std::uint64_t NowNs() noexcept
+	{
+		return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+}
+
+std::atomic_uint32_t Scheduler::nextId_{ 1 };
+
 Scheduler::Scheduler(lutask::schedule::IPolicy* policy) noexcept
-	: mainContext_(nullptr)
+	: id_(nextId_.fetch_add(1, std::memory_order_relaxed))
+	, mainContext_(nullptr)
 	, dispatcherContext_(nullptr)
 	, policy_(policy)
 	, shutdown_(false)
 {
+	counters_.busySince.store(NowNs(), std::memory_order_relaxed);
 }
 
 Scheduler::~Scheduler()
@@ -20,43 +34,107 @@ Scheduler::~Scheduler()
 
     Context::Active()->Suspend();
 
-    assert(workerQueue_.empty());
-    assert(terminatedQueue_.empty());
+    assert(workerQueue_.IsEmpty());
+    assert(terminatedQueue_.IsEmpty());
+    assert(nullptr == remoteHead_.load(std::memory_order_relaxed));
     assert(sleepQueue_.empty());
+    assert(timerWheel_.IsEmpty());
 
     Context::ResetActive();
     dispatcherContext_.reset();
     mainContext_ = nullptr;
+    delete latency_.load(std::memory_order_acquire);
 }
 
 void Scheduler::ProcTerminated()
 {
     Context* ctx = nullptr;
-    while (terminatedQueue_.try_pop(ctx))
+    while (terminatedQueue_.TryPop(ctx))
     {
         if (ctx == nullptr)
             continue;
 
         assert(ctx->IsContext(EType::WorkerContext));
         assert(this == ctx->GetScheduler());
-        assert(ctx->terminated_);    
+        assert(ctx->terminated_);
+
+        // drop the reference held since MakeWorkerContext(), the last
+        // owner unwinds the fiber and hands its stack back to the allocator
+        intrusive_ptr_release(ctx);
+    }
+}
+
+void Scheduler::ProcRemoteReady() noexcept
+{
+    if (nullptr == remoteHead_.load(std::memory_order_relaxed))
+        return;
+
+    Context* head = remoteHead_.exchange(nullptr, std::memory_order_acquire);
+
+    // pushed as a stack, reverse it so contexts run in the order they were woken
+    Context* ordered = nullptr;
+    while (nullptr != head)
+    {
+        Context* next = head->remoteNext_;
+        head->remoteNext_ = ordered;
+        ordered = head;
+        head = next;
+    }
+
+    while (nullptr != ordered)
+    {
+        Context* ctx = ordered;
+        ordered = ctx->remoteNext_;
+        ctx->remoteNext_ = nullptr;
+
+        // handed over by YieldOrigin(), it joins this scheduler first
+        if (nullptr == ctx->GetScheduler())
+        {
+            AttachWorkerContext(ctx);
+        }
+        // stamped by ScheduleRemote(), the wait in the inbox counts as ready time
+        Awaken(ctx);
     }
 }
 
 void Scheduler::ProcSleepToReady()
 {
     std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (ESleepQueue::TimerWheel == sleepMode_)
+    {
+        if (timerWheel_.IsEmpty())
+            return;
+
+        TimerWheel::List expired;
+        timerWheel_.Expire(now, expired);
+        counters_.sleeping.store(timerWheel_.Size(), std::memory_order_relaxed);
+        while (Context* ctx = expired.PopFront())
+        {
+            assert(!ctx->IsContext(EType::DispatcherContext));
+            ctx->tp_ = (std::chrono::steady_clock::time_point::max)();
+            // a notify from another thread may have claimed it already
+            if (ctx->ClaimWakeup(EWait::Expired))
+            {
+                Schedule(ctx);
+            }
+        }
+        return;
+    }
+
     for (auto iter = sleepQueue_.begin(); iter != sleepQueue_.end();)
     {
         Context* ctx = (*iter);
         assert(!ctx->IsContext(EType::DispatcherContext));
-        assert(mainContext_ == ctx);
 
         if (ctx->tp_ <= now) 
         {
             iter = sleepQueue_.erase(iter);
+            counters_.sleeping.store(sleepQueue_.size(), std::memory_order_relaxed);
             ctx->tp_ = (std::chrono::steady_clock::time_point::max)();
-            Schedule(ctx);
+            if (ctx->ClaimWakeup(EWait::Expired))
+            {
+                Schedule(ctx);
+            }
         }
         else 
         {
@@ -65,13 +143,244 @@ void Scheduler::ProcSleepToReady()
     }
 }
 
+void Scheduler::CancelSleep(Context* ctx) noexcept
+{
+    if (ESleepQueue::TimerWheel == sleepMode_)
+    {
+        timerWheel_.Remove(ctx);
+    }
+    else
+    {
+        auto range = sleepQueue_.equal_range(ctx);
+        for (auto iter = range.first; iter != range.second; ++iter)
+        {
+            if (*iter == ctx)
+            {
+                sleepQueue_.erase(iter);
+                break;
+            }
+        }
+    }
+    ctx->tp_ = (std::chrono::steady_clock::time_point::max)();
+    counters_.sleeping.store(GetSleepCount(), std::memory_order_relaxed);
+}
+
+std::chrono::steady_clock::time_point Scheduler::NextSleepDeadline() noexcept
+{
+    if (ESleepQueue::TimerWheel == sleepMode_)
+    {
+        return timerWheel_.NextDeadline();
+    }
+
+    auto iter = sleepQueue_.begin();
+    if (sleepQueue_.end() != iter)
+    {
+        return (*iter)->tp_;
+    }
+    return (std::chrono::steady_clock::time_point::max)();
+}
+
+void Scheduler::SetSleepQueue(ESleepQueue mode, std::chrono::steady_clock::duration tick) noexcept
+{
+    assert(sleepQueue_.empty());
+    assert(timerWheel_.IsEmpty());
+
+    sleepMode_ = mode;
+    if (ESleepQueue::TimerWheel == mode)
+    {
+        timerWheel_.Reset(tick);
+    }
+}
+
+std::size_t Scheduler::GetSleepCount() const noexcept
+{
+    return ESleepQueue::TimerWheel == sleepMode_ ? timerWheel_.Size() : sleepQueue_.size();
+}
+
+SchedulerStats Scheduler::GetStats() const noexcept
+{
+    SchedulerStats stats;
+    stats.Switches = counters_.switches.load(std::memory_order_relaxed);
+    stats.Spawns = counters_.spawns.load(std::memory_order_relaxed);
+    stats.Terminations = counters_.terminations.load(std::memory_order_relaxed);
+    stats.Steals = counters_.steals.load(std::memory_order_relaxed);
+    stats.Migrations = counters_.migrations.load(std::memory_order_relaxed);
+    stats.Wakeups = counters_.wakeups.load(std::memory_order_relaxed);
+    stats.IdleNs = counters_.idleNs.load(std::memory_order_relaxed);
+    stats.BusyNs = counters_.busyNs.load(std::memory_order_relaxed);
+    stats.Fibers = workerCount_.load(std::memory_order_relaxed);
+    stats.Sleeping = counters_.sleeping.load(std::memory_order_relaxed);
+
+    // the stretch in progress is only added up when it ends
+    const std::uint64_t now = NowNs();
+    const std::uint64_t busySince = counters_.busySince.load(std::memory_order_relaxed);
+    const std::uint64_t idleSince = counters_.idleSince.load(std::memory_order_relaxed);
+    if (0 != busySince && busySince < now)
+    {
+        stats.BusyNs += now - busySince;
+    }
+    else if (0 != idleSince && idleSince < now)
+    {
+        stats.IdleNs += now - idleSince;
+    }
+    return stats;
+}
+
+SchedulerLatency Scheduler::GetLatency() const noexcept
+{
+    SchedulerLatency latency;
+    if (Latency const* histograms = latency_.load(std::memory_order_acquire))
+    {
+        latency.ReadyWait = histograms->readyWait.Snapshot();
+        latency.RunSlice = histograms->runSlice.Snapshot();
+    }
+    return latency;
+}
+
+void Scheduler::EnableLatencyHistograms()
+{
+    if (nullptr != latency_.load(std::memory_order_acquire))
+        return;
+
+    Latency* latency = new Latency();
+    Latency* expected = nullptr;
+    if (latency_.compare_exchange_strong(expected, latency, std::memory_order_acq_rel) == false)
+    {
+        // another thread was first
+        delete latency;
+    }
+}
+
+void Scheduler::StampReady(Context* ctx) noexcept
+{
+    if (nullptr != latency_.load(std::memory_order_relaxed))
+    {
+        ctx->readySince_ = NowNs();
+    }
+}
+
+void Scheduler::TimeSwitch(Context* from, Context* to) noexcept
+{
+    Latency* latency = latency_.load(std::memory_order_acquire);
+    if (nullptr == latency)
+        return;
+
+    // one clock read per switch, and only while measuring
+    const std::uint64_t now = NowNs();
+    // time in the dispatcher is nobody's run slice
+    if (0 != sliceStart_ && from->IsContext(EType::DispatcherContext) == false)
+    {
+        latency->runSlice.Record(now - sliceStart_);
+    }
+    sliceStart_ = now;
+
+    if (0 != to->readySince_)
+    {
+        // stamped by another thread, the clocks may disagree by a hair
+        latency->readyWait.Record(to->readySince_ < now ? now - to->readySince_ : 0);
+        to->readySince_ = 0;
+    }
+}
+
+Context* Scheduler::PickNextSwitch() noexcept
+{
+    detail::Bump(counters_.switches);
+    Context* from = Context::Active();
+    Context* next = policy_->PickNext();
+    TimeSwitch(from, next);
+    return next;
+}
+
 void Scheduler::Schedule(Context* ctx) noexcept
 {
     assert(nullptr != ctx);
 
+    LUTASK_TRACE_EVENT(Ready, ctx, this);
+    StampReady(ctx);
+    Awaken(ctx);
+}
+
+void Scheduler::Awaken(Context* ctx) noexcept
+{
+    // woken before its deadline, the timer is void
+    if ((std::chrono::steady_clock::time_point::max)() != ctx->tp_)
+    {
+        CancelSleep(ctx);
+    }
+
     policy_->Awakened(ctx);
 }
 
+void Scheduler::ScheduleAsync(Context* ctx) noexcept
+{
+    assert(nullptr != ctx);
+    assert(nullptr == ctx->GetScheduler());
+
+    LUTASK_TRACE_EVENT(Ready, ctx, this);
+    StampReady(ctx);
+    policy_->AwakenedAsync(ctx);
+}
+
+void Scheduler::ScheduleBatch(Context* const* ctxs, std::size_t count) noexcept
+{
+    // a policy that shares its fibers with other threads would detach each
+    // one right away, taking mtx_ once more per context
+    if (policy_->DetachesAwakened() == false)
+    {
+        AttachWorkerContexts(ctxs, count);
+    }
+
+    // never started, so none of them can be sleeping
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        assert((std::chrono::steady_clock::time_point::max)() == ctxs[i]->tp_);
+        LUTASK_TRACE_EVENT(Ready, ctxs[i], this);
+        StampReady(ctxs[i]);
+    }
+    policy_->AwakenedBatch(ctxs, count);
+}
+
+void Scheduler::ScheduleAsyncBatch(Context* const* ctxs, std::size_t count) noexcept
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        assert(nullptr == ctxs[i]->GetScheduler());
+        LUTASK_TRACE_EVENT(Ready, ctxs[i], this);
+        StampReady(ctxs[i]);
+    }
+    policy_->AwakenedAsyncBatch(ctxs, count);
+}
+
+void Scheduler::ScheduleRemote(Context* ctx) noexcept
+{
+    assert(nullptr != ctx);
+    assert(nullptr == ctx->GetScheduler() || this == ctx->GetScheduler());
+
+    LUTASK_TRACE_EVENT(Ready, ctx, this);
+    StampReady(ctx);
+    Context* head = remoteHead_.load(std::memory_order_relaxed);
+    do
+    {
+        ctx->remoteNext_ = head;
+    } while (remoteHead_.compare_exchange_weak(head, ctx,
+        std::memory_order_release, std::memory_order_relaxed) == false);
+
+    // only the push that finds the inbox empty signals, the dispatcher
+    // drains everything queued behind it in the same round
+    if (nullptr == head)
+    {
+        policy_->Notify();
+    }
+}
+
+void Scheduler::PriorityChanged(Context* ctx) noexcept
+{
+    assert(nullptr != ctx);
+    assert(this == ctx->GetScheduler());
+
+    policy_->PriorityChanged(ctx);
+}
+
 lutask::context::FiberContext Scheduler::Dispatch() noexcept
 {
     assert(Context::Active() == dispatcherContext_.get());
@@ -81,30 +390,40 @@ lutask::context::FiberContext Scheduler::Dispatch() noexcept
         {
             // ˴ٿ   ۾ ó
             policy_->Notify();
-            if (workerQueue_.empty()) 
+            // detached fibers queued for stealing are nobody's worker yet,
+            // they are run before the thread goes away
+            if (workerQueue_.IsEmpty() && policy_->HasReadyFibers() == false)
                 break;
         }
 
         ProcTerminated();
+        ProcRemoteReady();
         ProcSleepToReady();
 
         Context* ctx = policy_->PickNext();
         if (nullptr != ctx) 
         {
             assert(ctx->IsResumable());
+            detail::Bump(counters_.switches);
+            TimeSwitch(dispatcherContext_.get(), ctx);
             ctx->Resume(dispatcherContext_.get());
             assert(Context::Active() == dispatcherContext_.get());
         }
         else 
         {
-            auto suspendTime = std::chrono::steady_clock::time_point::max();
-
-            auto iter = sleepQueue_.begin();
-            if (sleepQueue_.end() != iter)
-            {
-                suspendTime = (*iter)->tp_;
-            }
-            policy_->SuspendUntil(suspendTime);
+            // two clock reads per idle stretch, none on the switch path
+            const std::uint64_t idleSince = NowNs();
+            detail::Bump(counters_.busyNs, idleSince - counters_.busySince.load(std::memory_order_relaxed));
+            counters_.busySince.store(0, std::memory_order_relaxed);
+            counters_.idleSince.store(idleSince, std::memory_order_relaxed);
+
+            policy_->SuspendUntil(NextSleepDeadline());
+
+            const std::uint64_t busySince = NowNs();
+            detail::Bump(counters_.idleNs, busySince - idleSince);
+            detail::Bump(counters_.wakeups);
+            counters_.idleSince.store(0, std::memory_order_relaxed);
+            counters_.busySince.store(busySince, std::memory_order_relaxed);
         }
     }
     ProcTerminated();
@@ -115,16 +434,25 @@ lutask::context::FiberContext Scheduler::Dispatch() noexcept
 
 lutask::context::FiberContext Scheduler::Terminate(Context* ctx) noexcept
 {
-    std::unique_lock<std::mutex> lk(mtx_);
-
     assert(nullptr != ctx);
     assert(Context::Active() == ctx);
     assert(this == ctx->GetScheduler());
     assert(ctx->IsContext(EType::WorkerContext));
 
-    terminatedQueue_.push(ctx);
-    workerQueue_.remove(ctx);
-    return policy_->PickNext()->SuspendWithCC();
+    // the dispatcher may not run for a long time when fibers hand over to
+    // each other directly, release what earlier fibers left behind here
+    ProcTerminated();
+
+    {
+        // must not be held across the switch, PickNext() may attach
+        std::unique_lock<std::mutex> lk(mtx_);
+        terminatedQueue_.Push(ctx);
+        workerQueue_.Remove(ctx);
+        workerCount_.store(workerQueue_.Size(), std::memory_order_relaxed);
+    }
+    detail::Bump(counters_.terminations);
+    LUTASK_TRACE_EVENT(Terminate, ctx, this);
+    return PickNextSwitch()->SuspendWithCC();
 }
 
 void Scheduler::Yield(Context* ctx) noexcept
@@ -133,9 +461,9 @@ void Scheduler::Yield(Context* ctx) noexcept
     assert(Context::Active() == ctx);
     assert(ctx->IsContext(EType::WorkerContext) || ctx->IsContext(EType::MainContext));
 
-
-    workerQueue_.remove(ctx);
-    policy_->PickNext()->Resume(ctx);
+    // ctx stays attached, it is only put back into the ready queue
+    LUTASK_TRACE_EVENT(Yield, ctx, this);
+    PickNextSwitch()->Resume(ctx);
 }
 
 void Scheduler::YieldOrigin(Context* ctx) noexcept
@@ -144,43 +472,95 @@ void Scheduler::YieldOrigin(Context* ctx) noexcept
     assert(Context::Active() == ctx);
     assert(ctx->IsContext(EType::WorkerContext) || ctx->IsContext(EType::MainContext));
 
-    workerQueue_.remove(ctx);
-
-    if (ctx->originScheduler_ != nullptr)
+    if (ctx->originScheduler_ != nullptr && ctx->originScheduler_ != this)
     {
-        //std::cout << "yield origin: " << ctx << std::endl;
+        {
+            std::unique_lock<std::mutex> lk(mtx_);
+            workerQueue_.Remove(ctx);
+            workerCount_.store(workerQueue_.Size(), std::memory_order_relaxed);
+        }
+        LUTASK_TRACE_EVENT(Migrate, ctx, this);
+        // PickNext() may attach through the active context, unlink ctx afterwards
+        Context* next = PickNextSwitch();
+        detail::Bump(counters_.migrations);
         ctx->scheduler_ = nullptr;
-        ctx->originScheduler_->Schedule(ctx);
-        //policy_->PickNext()->Resume();
+        // ctx reaches the origin's inbox only after it was switched out
+        next->Resume(ctx);
     }
     else
     {
-        policy_->PickNext()->Resume(ctx);
+        LUTASK_TRACE_EVENT(Yield, ctx, this);
+        PickNextSwitch()->Resume(ctx);
     }
 }
 
-bool Scheduler::WaitUntil(Context* ctx, std::chrono::steady_clock::time_point const& tp) noexcept
+void Scheduler::Sleep(Context* ctx, std::chrono::steady_clock::time_point const& tp) noexcept
 {
     assert(nullptr != ctx);
     assert(Context::Active() == ctx);
     assert(ctx->IsContext(EType::WorkerContext) || ctx->IsContext(EType::MainContext));
 
     ctx->tp_ = tp;
-    sleepQueue_.insert(ctx);
+    if (ESleepQueue::TimerWheel == sleepMode_)
+    {
+        timerWheel_.Insert(ctx);
+    }
+    else
+    {
+        sleepQueue_.insert(ctx);
+    }
+    counters_.sleeping.store(GetSleepCount(), std::memory_order_relaxed);
+}
+
+bool Scheduler::WaitUntil(Context* ctx, std::chrono::steady_clock::time_point const& tp) noexcept
+{
+    Sleep(ctx, tp);
+    LUTASK_TRACE_EVENT(Suspend, ctx, this);
 
-    policy_->PickNext()->Resume(ctx);
+    // ctx becomes ready again through ProcSleepToReady() or an early Schedule()
+    PickNextSwitch()->Resume();
+
+    return std::chrono::steady_clock::now() < tp;
+}
+
+bool Scheduler::WaitUntil(Context* ctx, std::chrono::steady_clock::time_point const& tp,
+    std::unique_lock<std::mutex>& lk) noexcept
+{
+    Sleep(ctx, tp);
+    LUTASK_TRACE_EVENT(Suspend, ctx, this);
+
+    // lk is released once ctx is switched out, a notifier may wake it from then on
+    PickNextSwitch()->Resume(lk);
+
+    return std::chrono::steady_clock::now() < tp;
+}
+
+bool Scheduler::WaitUntil(Context* ctx, std::chrono::steady_clock::time_point const& tp,
+    std::unique_lock<detail::Spinlock>& lk) noexcept
+{
+    Sleep(ctx, tp);
+    LUTASK_TRACE_EVENT(Suspend, ctx, this);
+    PickNextSwitch()->Resume(lk);
 
     return std::chrono::steady_clock::now() < tp;
 }
 
 void Scheduler::Suspend() noexcept
 {
-    policy_->PickNext()->Resume();
+    LUTASK_TRACE_EVENT(Suspend, Context::Active(), this);
+    PickNextSwitch()->Resume();
 }
 
 void Scheduler::Suspend(std::unique_lock<std::mutex>& lk) noexcept
 {
-    policy_->PickNext()->Resume(lk);
+    LUTASK_TRACE_EVENT(Suspend, Context::Active(), this);
+    PickNextSwitch()->Resume(lk);
+}
+
+void Scheduler::Suspend(std::unique_lock<detail::Spinlock>& lk) noexcept
+{
+    LUTASK_TRACE_EVENT(Suspend, Context::Active(), this);
+    PickNextSwitch()->Resume(lk);
 }
 
 void Scheduler::AttachMainContext(Context* ctx) noexcept
@@ -203,16 +583,33 @@ void Scheduler::AttachWorkerContext(Context* ctx) noexcept
     assert(nullptr != ctx);
     assert(nullptr == ctx->GetScheduler());
 
-    workerQueue_.push_back(ctx);
+    workerQueue_.PushBack(ctx);
+    workerCount_.store(workerQueue_.Size(), std::memory_order_relaxed);
     ctx->scheduler_ = this;
     // an attached context must belong at least to worker-queue
 }
 
+void Scheduler::AttachWorkerContexts(Context* const* ctxs, std::size_t count) noexcept
+{
+    std::unique_lock<std::mutex> lk(mtx_);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        assert(nullptr != ctxs[i]);
+        assert(nullptr == ctxs[i]->GetScheduler());
+
+        workerQueue_.PushBack(ctxs[i]);
+        ctxs[i]->scheduler_ = this;
+    }
+    workerCount_.store(workerQueue_.Size(), std::memory_order_relaxed);
+}
+
 void Scheduler::DetachWorkerContext(Context* ctx) noexcept
 {
     assert(nullptr != ctx);
     assert(ctx->IsContext(EType::PinnedContext) == false);
-    workerQueue_.remove(ctx);
+    workerQueue_.Remove(ctx);
+    workerCount_.store(workerQueue_.Size(), std::memory_order_relaxed);
     // unlink
     ctx->scheduler_ = nullptr;
 }
@@ -0,0 +1,108 @@
+#include <lutask/TaskArena.h>
+#include <lutask/detail/BlockCache.h>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <limits>
+
+namespace lutask
+{
+
+namespace
+{
+	struct ArenaTraits
+	{
+		static constexpr std::size_t Classes = TaskArena::MaxBlockSize / TaskArena::Granularity;
+		static constexpr std::size_t Shards = 1;
+		static constexpr std::size_t LocalCapacity = TaskArena::LocalCapacity;
+		// slabs stay for the lifetime of the process, so every block is kept
+		static constexpr std::size_t GlobalCapacity = (std::numeric_limits<std::size_t>::max)();
+		static constexpr bool TrackHighWater = false;
+
+		static std::size_t CurrentShard() noexcept
+		{
+			return 0;
+		}
+
+		static void Release(void*) noexcept
+		{
+		}
+	};
+
+	using Cache = detail::BlockCache<ArenaTraits>;
+
+	inline std::size_t ClassOf(std::size_t size) noexcept
+	{
+		return (size + TaskArena::Granularity - 1) / TaskArena::Granularity - 1;
+	}
+
+	std::atomic_size_t slabs{ 0 };
+
+	// unused tail of the slab blocks are carved from, plain pointers so it
+	// outlives the thread's other storage
+	thread_local char* cursor = nullptr;
+	thread_local char* end = nullptr;
+
+	void* Carve(std::size_t blockSize)
+	{
+		if (static_cast<std::size_t>(end - cursor) < blockSize)
+		{
+			// the tail of the old slab is abandoned, it is smaller than any block we need
+			char* slab = static_cast<char*>(std::malloc(TaskArena::SlabSize));
+			if (nullptr == slab)
+			{
+				throw std::bad_alloc();
+			}
+			cursor = slab;
+			end = slab + TaskArena::SlabSize;
+			slabs.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void* vp = cursor;
+		cursor += blockSize;
+		return vp;
+	}
+}
+
+void* TaskArena::Allocate(std::size_t size)
+{
+	if (size > MaxBlockSize)
+	{
+		return ::operator new(size);
+	}
+
+	const std::size_t index = ClassOf((std::max)(size, Cache::MinBlockSize));
+	if (void* vp = Cache::Pop(index))
+	{
+		return vp;
+	}
+	return Carve((index + 1) * Granularity);
+}
+
+void TaskArena::Deallocate(void* vp, std::size_t size) noexcept
+{
+	assert(nullptr != vp);
+
+	if (size > MaxBlockSize)
+	{
+		::operator delete(vp);
+		return;
+	}
+
+	Cache::Push(ClassOf((std::max)(size, Cache::MinBlockSize)), 0, vp);
+}
+
+TaskArenaStats TaskArena::Stats() noexcept
+{
+	detail::BlockCacheStats cache = Cache::Stats();
+
+	TaskArenaStats stats;
+	stats.Hits = cache.Hits;
+	stats.Misses = cache.Misses;
+	stats.Slabs = slabs.load(std::memory_order_relaxed);
+	stats.Cached = cache.Cached;
+	return stats;
+}
+
+}
@@ -0,0 +1,256 @@
+#include <lutask/ThreadPool.h>
+#include <lutask/Fiber.h>
+#include <lutask/Scheduler.h>
+#include <lutask/context/PooledFixedSizeStack.h>
+#include <lutask/schedule/WorkStealingPolicy.h>
+#include <lutask/Topology.h>
+#include <algorithm>
+#include <memory>
+
+namespace lutask
+{
+
+namespace
+{
+	// the pool the current thread works for, nullptr outside of any pool
+	thread_local ThreadPool* currentPool_ = nullptr;
+}
+
+ThreadPool::PolicyFactory ThreadPool::DefaultPolicy()
+{
+	std::shared_ptr<schedule::WorkStealingGroup> group = std::make_shared<schedule::WorkStealingGroup>();
+	return [group]() { return new schedule::WorkStealingPolicy(group, true); };
+}
+
+ThreadPool::ThreadPool(std::size_t threadCount, PolicyFactory factory, bool pinThreads)
+	: factory_(std::move(factory))
+	, schedulers_((std::max)(threadCount, static_cast<std::size_t>(1)), nullptr)
+	, retired_(schedulers_.size())
+{
+	threads_.reserve(schedulers_.size());
+	for (std::size_t i = 0; i < schedulers_.size(); ++i)
+	{
+		threads_.emplace_back(&ThreadPool::Work, this, i, pinThreads);
+	}
+
+	// the pool is usable once every worker has its scheduler
+	std::unique_lock<std::mutex> lk(mtx_);
+	cnd_.Wait(lk, [this]() { return schedulers_.size() == started_; });
+}
+
+ThreadPool::~ThreadPool()
+{
+	Shutdown();
+}
+
+void ThreadPool::Work(std::size_t index, bool pinThreads)
+{
+	// pinned before the policy is made, it takes the node of its thread
+	if (pinThreads)
+	{
+		Topology::PinCurrentThread(Topology::CpuAt(index));
+	}
+	Context::InitializeThread(factory_(), context::FixedSizeStack());
+	currentPool_ = this;
+
+	std::unique_lock<std::mutex> lk(mtx_);
+	schedulers_[index] = Context::Active()->GetScheduler();
+	if (schedulers_.size() == ++started_)
+	{
+		cnd_.NotifyAll();
+	}
+	lk.unlock();
+
+	// The main context feeds the dispatcher: it turns one queued task into a
+	// fiber whenever the policy gives it a turn, so only running and blocked
+	// tasks hold a stack. Once released, the scheduler's destructor finishes
+	// what is still attached.
+	Context* ctx = Context::Active();
+	bool woken = false;
+	for (;;)
+	{
+		Task* task = nullptr;
+		const bool popped = tasks_.TryPop(task);
+		if (woken)
+		{
+			// hand the wake token on, Submit() stayed quiet while we held it
+			woken = false;
+			waking_.store(false, std::memory_order_seq_cst);
+			if (popped && tasks_.IsEmpty() == false)
+			{
+				WakeIdle();
+			}
+		}
+
+		if (popped)
+		{
+			Fiber(ELaunch::Dispatch, std::allocator_arg, context::PooledFixedSizeStack(), [this, task]()
+			{
+				task->Run();
+				Leave();
+			}).Detach();
+			continue;
+		}
+
+		std::unique_lock<detail::Spinlock> lk(splk_);
+		if (done_)
+			break;
+
+		// announced before the retry, a Submit() after it sees us; whoever
+		// wakes us takes the count back
+		idle_.fetch_add(1, std::memory_order_seq_cst);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (tasks_.IsEmpty() == false)
+		{
+			idle_.fetch_sub(1, std::memory_order_relaxed);
+			continue;
+		}
+		idleWorkers_.SuspendAndWait(lk, ctx);
+		woken = true;
+	}
+	currentPool_ = nullptr;
+
+	// the scheduler goes away with the thread, keep what it counted
+	lk.lock();
+	retired_[index] = schedulers_[index]->GetStats();
+	retiredLatency_ += schedulers_[index]->GetLatency();
+	schedulers_[index] = nullptr;
+}
+
+void ThreadPool::Shutdown()
+{
+	if (this == currentPool_)
+	{
+		throw FiberError(std::make_error_code(std::errc::resource_deadlock_would_occur),
+			"lutask: thread pool shut down from its own worker");
+	}
+	if (stopping_.exchange(true, std::memory_order_seq_cst))
+	{
+		// another caller drains, wait for it to finish
+		std::unique_lock<std::mutex> lk(mtx_);
+		cnd_.Wait(lk, [this]() { return threads_.empty(); });
+		return;
+	}
+
+	std::unique_lock<std::mutex> lk(mtx_);
+	cnd_.Wait(lk, [this]() { return 0 == pending_.load(std::memory_order_seq_cst); });
+	lk.unlock();
+	{
+		std::unique_lock<detail::Spinlock> idleLk(splk_);
+		done_ = true;
+		while (nullptr != idleWorkers_.NotifyOne())
+		{
+			idle_.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+
+	for (std::thread& t : threads_)
+	{
+		t.join();
+	}
+
+	lk.lock();
+	threads_.clear();
+	lk.unlock();
+	cnd_.NotifyAll();
+}
+
+SchedulerStats ThreadPool::GetStats(std::size_t index)
+{
+	std::unique_lock<std::mutex> lk(mtx_);
+	return nullptr != schedulers_[index] ? schedulers_[index]->GetStats() : retired_[index];
+}
+
+SchedulerStats ThreadPool::GetStats()
+{
+	std::unique_lock<std::mutex> lk(mtx_);
+	SchedulerStats stats;
+	for (std::size_t i = 0; i < schedulers_.size(); ++i)
+	{
+		stats += nullptr != schedulers_[i] ? schedulers_[i]->GetStats() : retired_[i];
+	}
+	return stats;
+}
+
+void ThreadPool::EnableLatencyHistograms()
+{
+	std::unique_lock<std::mutex> lk(mtx_);
+	for (Scheduler* scheduler : schedulers_)
+	{
+		if (nullptr != scheduler)
+		{
+			scheduler->EnableLatencyHistograms();
+		}
+	}
+}
+
+SchedulerLatency ThreadPool::GetLatency()
+{
+	std::unique_lock<std::mutex> lk(mtx_);
+	SchedulerLatency latency = retiredLatency_;
+	for (Scheduler* scheduler : schedulers_)
+	{
+		if (nullptr != scheduler)
+		{
+			latency += scheduler->GetLatency();
+		}
+	}
+	return latency;
+}
+
+void ThreadPool::Enter()
+{
+	// counted before the check, Shutdown() either sees the task or we see it stopping;
+	// our own fibers keep posting while draining, they are pending work themselves
+	pending_.fetch_add(1, std::memory_order_seq_cst);
+	if (stopping_.load(std::memory_order_seq_cst) && this != currentPool_)
+	{
+		Leave();
+		throw FiberError(std::make_error_code(std::errc::operation_not_permitted),
+			"lutask: thread pool is shut down");
+	}
+}
+
+void ThreadPool::Leave() noexcept
+{
+	if (1 == pending_.fetch_sub(1, std::memory_order_seq_cst) && stopping_.load(std::memory_order_seq_cst))
+	{
+		// taken so the drain can not miss the notify between its check and its wait
+		std::unique_lock<std::mutex> lk(mtx_);
+		lk.unlock();
+		cnd_.NotifyAll();
+	}
+}
+
+void ThreadPool::Submit(Task* task) noexcept
+{
+	tasks_.Push(task);
+
+	// pairs with the fetch_add of a parking worker, one of us sees the other
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (0 == idle_.load(std::memory_order_relaxed))
+		return;
+
+	WakeIdle();
+}
+
+void ThreadPool::WakeIdle() noexcept
+{
+	// one wake in flight at a time, a burst of posts costs one wake and the
+	// woken worker passes it on while work is left
+	if (waking_.exchange(true, std::memory_order_seq_cst))
+		return;
+
+	std::unique_lock<detail::Spinlock> lk(splk_);
+	if (nullptr != idleWorkers_.NotifyOne())
+	{
+		idle_.fetch_sub(1, std::memory_order_relaxed);
+	}
+	else
+	{
+		// the idle worker found work before parking
+		waking_.store(false, std::memory_order_seq_cst);
+	}
+}
+
+}
@@ -0,0 +1,266 @@
+#include <lutask/TimerWheel.h>
+#include <lutask/Context.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace lutask
+{
+
+namespace
+{
+	constexpr std::uint64_t NeverTick = ~static_cast<std::uint64_t>(0);
+	constexpr std::uint32_t DueSlot = TimerWheel::Levels * TimerWheel::Slots + 1;
+
+	inline std::uint64_t RotateRight(std::uint64_t x, std::size_t n) noexcept
+	{
+		n &= 63;
+		return 0 == n ? x : (x >> n) | (x << (64 - n));
+	}
+
+	inline std::size_t CountTrailingZeros(std::uint64_t x) noexcept
+	{
+		assert(0 != x);
+#if defined(_MSC_VER)
+		unsigned long idx;
+		_BitScanForward64(&idx, x);
+		return static_cast<std::size_t>(idx);
+#else
+		return static_cast<std::size_t>(__builtin_ctzll(x));
+#endif
+	}
+
+	inline detail::ListHook<SleepHookTag>* SleepHook(Context* ctx) noexcept
+	{
+		return ctx;
+	}
+}
+
+TimerWheel::TimerWheel(Duration tick) noexcept
+	: tick_(tick)
+	, start_(std::chrono::steady_clock::now())
+{
+	assert(tick_.count() > 0);
+}
+
+void TimerWheel::Reset(Duration tick) noexcept
+{
+	assert(IsEmpty());
+	assert(tick.count() > 0);
+
+	tick_ = tick;
+	start_ = std::chrono::steady_clock::now();
+	currentTick_ = 0;
+}
+
+std::uint64_t TimerWheel::ToTick(TimePoint const& tp) const noexcept
+{
+	if ((TimePoint::max)() == tp)
+		return NeverTick;
+	if (tp <= start_)
+		return 0;
+
+	const Duration d = tp - start_;
+	if (d > (Duration::max)() - tick_)
+		return NeverTick;
+
+	// round up, a timer must never fire before its deadline
+	return static_cast<std::uint64_t>((d + tick_ - Duration(1)) / tick_);
+}
+
+void TimerWheel::Link(Context* ctx) noexcept
+{
+	const std::uint64_t tick = ToTick(ctx->tp_);
+	if (tick <= currentTick_)
+	{
+		ctx->timerSlot_ = DueSlot;
+		due_.PushBack(ctx);
+		return;
+	}
+
+	for (std::size_t level = 0; level < Levels; ++level)
+	{
+		const std::size_t shift = level * SlotBits;
+		if ((tick >> shift) - (currentTick_ >> shift) < Slots)
+		{
+			const std::size_t slot = static_cast<std::size_t>(tick >> shift) & (Slots - 1);
+			ctx->timerSlot_ = static_cast<std::uint32_t>(level * Slots + slot);
+			slots_[level * Slots + slot].PushBack(ctx);
+			occupied_[level] |= std::uint64_t(1) << slot;
+			return;
+		}
+	}
+
+	ctx->timerSlot_ = OverflowSlot;
+	overflow_.PushBack(ctx);
+}
+
+void TimerWheel::Insert(Context* ctx) noexcept
+{
+	assert(nullptr != ctx);
+	assert(!SleepHook(ctx)->IsLinked());
+
+	Link(ctx);
+	++size_;
+}
+
+void TimerWheel::Remove(Context* ctx) noexcept
+{
+	assert(nullptr != ctx);
+	if (!SleepHook(ctx)->IsLinked())
+		return;
+
+	const std::uint32_t idx = ctx->timerSlot_;
+	if (DueSlot == idx)
+	{
+		due_.Remove(ctx);
+	}
+	else if (OverflowSlot == idx)
+	{
+		overflow_.Remove(ctx);
+	}
+	else
+	{
+		slots_[idx].Remove(ctx);
+		if (slots_[idx].IsEmpty())
+		{
+			occupied_[idx / Slots] &= ~(std::uint64_t(1) << (idx % Slots));
+		}
+	}
+	--size_;
+}
+
+void TimerWheel::Cascade(std::size_t level, std::size_t slot) noexcept
+{
+	List pending;
+	pending.Splice(slots_[level * Slots + slot]);
+	occupied_[level] &= ~(std::uint64_t(1) << slot);
+
+	while (Context* ctx = pending.PopFront())
+	{
+		Link(ctx);
+	}
+}
+
+void TimerWheel::Tick(std::uint64_t tick) noexcept
+{
+	currentTick_ = tick;
+
+	if (0 == (tick & ((std::uint64_t(1) << ((Levels - 1) * SlotBits)) - 1)) && !overflow_.IsEmpty())
+	{
+		List pending;
+		pending.Splice(overflow_);
+		while (Context* ctx = pending.PopFront())
+		{
+			Link(ctx);
+		}
+	}
+
+	// higher levels first, their timers may land in the slot expiring now
+	for (std::size_t level = Levels - 1; level > 0; --level)
+	{
+		const std::size_t shift = level * SlotBits;
+		if (0 == (tick & ((std::uint64_t(1) << shift) - 1)))
+		{
+			Cascade(level, static_cast<std::size_t>(tick >> shift) & (Slots - 1));
+		}
+	}
+
+	const std::size_t slot = static_cast<std::size_t>(tick) & (Slots - 1);
+	due_.Splice(slots_[slot]);
+	occupied_[0] &= ~(std::uint64_t(1) << slot);
+}
+
+void TimerWheel::Expire(TimePoint const& now, List& expired) noexcept
+{
+	if (0 == size_)
+		return;
+
+	// the tick now falls into, part of its timers may be due already
+	const std::uint64_t nowTick = ToTick(now);
+	while (currentTick_ < nowTick)
+	{
+		if (0 == occupied_[0])
+		{
+			// nothing can fire before the next level-1 boundary
+			const std::uint64_t boundary = ((currentTick_ >> SlotBits) + 1) << SlotBits;
+			if (boundary > nowTick)
+			{
+				currentTick_ = nowTick;
+				break;
+			}
+			currentTick_ = boundary - 1;
+		}
+		Tick(currentTick_ + 1);
+	}
+
+	// the rest of the current tick stays due, NextDeadline() names it exactly
+	due_.ForEach([&](Context* ctx)
+		{
+			if (ctx->tp_ <= now)
+			{
+				due_.Remove(ctx);
+				expired.PushBack(ctx);
+				--size_;
+			}
+		});
+}
+
+TimerWheel::TimePoint TimerWheel::MinDeadline(List& list) noexcept
+{
+	TimePoint deadline = (TimePoint::max)();
+	list.ForEach([&](Context* ctx)
+		{
+			deadline = (std::min)(deadline, ctx->tp_);
+		});
+	return deadline;
+}
+
+TimerWheel::TimePoint TimerWheel::NextDeadline() noexcept
+{
+	if (0 == size_)
+		return (TimePoint::max)();
+	if (!due_.IsEmpty())
+		return MinDeadline(due_);
+
+	// the tick of the earliest timer found so far and its exact deadline
+	std::uint64_t best = NeverTick;
+	TimePoint deadline = (TimePoint::max)();
+	if (0 != occupied_[0])
+	{
+		// a level-0 slot holds the timers of a single tick
+		const std::uint64_t next = currentTick_ + 1;
+		best = next + CountTrailingZeros(RotateRight(occupied_[0], static_cast<std::size_t>(next)));
+		deadline = MinDeadline(slots_[best & (Slots - 1)]);
+	}
+
+	for (std::size_t level = 1; level < Levels; ++level)
+	{
+		if (0 == occupied_[level])
+			continue;
+
+		// first occupied slot of this level, its timers are due no earlier
+		// than the tick it cascades at
+		const std::size_t shift = level * SlotBits;
+		const std::uint64_t nextBlock = (currentTick_ >> shift) + 1;
+		const std::uint64_t block = nextBlock + CountTrailingZeros(RotateRight(occupied_[level], static_cast<std::size_t>(nextBlock)));
+		if ((block << shift) <= best)
+		{
+			const TimePoint tp = MinDeadline(slots_[level * Slots + (block & (Slots - 1))]);
+			if (tp < deadline)
+			{
+				best = ToTick(tp);
+				deadline = tp;
+			}
+		}
+	}
+
+	if (NeverTick == best && !overflow_.IsEmpty())
+	{
+		deadline = MinDeadline(overflow_);
+	}
+	return deadline;
+}
+
+}
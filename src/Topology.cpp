@@ -0,0 +1,267 @@
+#include <lutask/Topology.h>
+#include <lutask/detail/MPMCQueue.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace lutask
+{
+
+namespace
+{
+	constexpr std::size_t NoNode = static_cast<std::size_t>(-1);
+
+	struct alignas(detail::CacheLineSize) NodeCounters
+	{
+		std::atomic_size_t localSteals{ 0 };
+		std::atomic_size_t remoteSteals{ 0 };
+		std::atomic_size_t migrationsOut{ 0 };
+		std::atomic_size_t bindFailures{ 0 };
+	};
+
+	struct Layout
+	{
+		std::vector<NumaNode> nodes;
+		std::vector<std::size_t> cpuNode;
+		std::vector<std::size_t> compact;
+		std::unique_ptr<NodeCounters[]> counters;
+
+		Layout()
+		{
+#if defined(__linux__)
+			Discover();
+#endif
+			if (nodes.empty())
+			{
+				NumaNode node;
+				const std::size_t cpuCount = (std::max)(std::thread::hardware_concurrency(), 1u);
+				for (std::size_t cpu = 0; cpu < cpuCount; ++cpu)
+				{
+					node.Cpus.push_back(cpu);
+				}
+				nodes.push_back(std::move(node));
+			}
+
+			std::size_t cpuCount = 0;
+			for (NumaNode const& node : nodes)
+			{
+				for (std::size_t cpu : node.Cpus)
+				{
+					cpuCount = (std::max)(cpuCount, cpu + 1);
+				}
+			}
+			cpuNode.assign(cpuCount, 0);
+			for (std::size_t i = 0; i < nodes.size(); ++i)
+			{
+				for (std::size_t cpu : nodes[i].Cpus)
+				{
+					cpuNode[cpu] = i;
+					compact.push_back(cpu);
+				}
+			}
+			counters.reset(new NodeCounters[nodes.size()]);
+		}
+
+#if defined(__linux__)
+		// "0-3,8-11"
+		static void ParseCpuList(char const* text, std::vector<std::size_t>& cpus)
+		{
+			while (*text != '\0' && *text != '\n')
+			{
+				char* end = nullptr;
+				std::size_t first = std::strtoul(text, &end, 10);
+				std::size_t last = first;
+				if ('-' == *end)
+				{
+					last = std::strtoul(end + 1, &end, 10);
+				}
+				for (std::size_t cpu = first; cpu <= last; ++cpu)
+				{
+					cpus.push_back(cpu);
+				}
+				if (',' != *end)
+					break;
+				text = end + 1;
+			}
+		}
+
+		void Discover()
+		{
+			DIR* dir = ::opendir("/sys/devices/system/node");
+			if (nullptr == dir)
+				return;
+
+			while (dirent* entry = ::readdir(dir))
+			{
+				if (std::strncmp(entry->d_name, "node", 4) != 0 || entry->d_name[4] < '0' || entry->d_name[4] > '9')
+					continue;
+
+				const std::string path = std::string("/sys/devices/system/node/") + entry->d_name + "/cpulist";
+				std::FILE* file = std::fopen(path.c_str(), "r");
+				if (nullptr == file)
+					continue;
+
+				char text[4096] = {};
+				if (nullptr != std::fgets(text, sizeof(text), file))
+				{
+					NumaNode node;
+					node.Id = std::strtoul(entry->d_name + 4, nullptr, 10);
+					ParseCpuList(text, node.Cpus);
+					// memory-only nodes have no cpu to run a worker on
+					if (node.Cpus.empty() == false)
+					{
+						nodes.push_back(std::move(node));
+					}
+				}
+				std::fclose(file);
+			}
+			::closedir(dir);
+
+			std::sort(nodes.begin(), nodes.end(),
+				[](NumaNode const& l, NumaNode const& r) { return l.Id < r.Id; });
+		}
+#endif
+	};
+
+	Layout& GetLayout()
+	{
+		static Layout layout;
+		return layout;
+	}
+
+	thread_local std::size_t currentNode_ = NoNode;
+}
+
+std::size_t Topology::NodeCount() noexcept
+{
+	return GetLayout().nodes.size();
+}
+
+std::size_t Topology::CpuCount() noexcept
+{
+	return GetLayout().compact.size();
+}
+
+NumaNode const& Topology::Node(std::size_t index) noexcept
+{
+	return GetLayout().nodes[index];
+}
+
+std::size_t Topology::NodeOfCpu(std::size_t cpu) noexcept
+{
+	Layout& layout = GetLayout();
+	return cpu < layout.cpuNode.size() ? layout.cpuNode[cpu] : 0;
+}
+
+std::size_t Topology::CpuAt(std::size_t index) noexcept
+{
+	Layout& layout = GetLayout();
+	return layout.compact[index % layout.compact.size()];
+}
+
+bool Topology::PinCurrentThread(std::size_t cpu) noexcept
+{
+#if defined(_WIN32)
+	const bool pinned = 0 != ::SetThreadAffinityMask(::GetCurrentThread(),
+		static_cast<DWORD_PTR>(1) << (cpu % (sizeof(DWORD_PTR) * 8)));
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	const bool pinned = 0 == ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+#else
+	const bool pinned = false;
+#endif
+	if (pinned)
+	{
+		currentNode_ = NodeOfCpu(cpu);
+	}
+	return pinned;
+}
+
+std::size_t Topology::CurrentNode() noexcept
+{
+	if (NoNode == currentNode_)
+	{
+		std::size_t node = 0;
+#if defined(__linux__)
+		const int cpu = ::sched_getcpu();
+		if (0 <= cpu)
+		{
+			node = NodeOfCpu(static_cast<std::size_t>(cpu));
+		}
+#endif
+		currentNode_ = node;
+	}
+	return currentNode_;
+}
+
+bool Topology::BindToNode(void* vp, std::size_t size, std::size_t node) noexcept
+{
+#if defined(__linux__) && defined(SYS_mbind)
+	if (NodeCount() < 2)
+		return true;
+
+	// MPOL_PREFERRED, falls back to other nodes instead of failing the fault
+	constexpr int PreferredPolicy = 1;
+	constexpr std::size_t Bits = sizeof(unsigned long) * 8;
+
+	const std::size_t id = Node(node).Id;
+	std::vector<unsigned long> mask(id / Bits + 1, 0);
+	mask[id / Bits] = 1ul << (id % Bits);
+	if (0 != ::syscall(SYS_mbind, vp, size, PreferredPolicy, mask.data(), mask.size() * Bits + 1, 0))
+	{
+		GetLayout().counters[node].bindFailures.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	return true;
+#else
+	(void)vp;
+	(void)size;
+	(void)node;
+	return true;
+#endif
+}
+
+void Topology::CountSteal(std::size_t thiefNode, std::size_t victimNode) noexcept
+{
+	NodeCounters* counters = GetLayout().counters.get();
+	if (thiefNode == victimNode)
+	{
+		counters[thiefNode].localSteals.fetch_add(1, std::memory_order_relaxed);
+	}
+	else
+	{
+		counters[thiefNode].remoteSteals.fetch_add(1, std::memory_order_relaxed);
+		counters[victimNode].migrationsOut.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+NumaNodeStats Topology::Stats(std::size_t node) noexcept
+{
+	NodeCounters const& counters = GetLayout().counters[node];
+
+	NumaNodeStats stats;
+	stats.LocalSteals = counters.localSteals.load(std::memory_order_relaxed);
+	stats.RemoteSteals = counters.remoteSteals.load(std::memory_order_relaxed);
+	stats.MigrationsOut = counters.migrationsOut.load(std::memory_order_relaxed);
+	stats.BindFailures = counters.bindFailures.load(std::memory_order_relaxed);
+	return stats;
+}
+
+}
@@ -0,0 +1,276 @@
+#include <lutask/Trace.h>
+#include <lutask/Context.h>
+#include <lutask/Scheduler.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace lutask
+{
+
+namespace
+{
+	struct Event
+	{
+		std::uint64_t ts;
+		std::uint64_t fiber;
+		std::uint32_t scheduler;
+		ETraceEvent event;
+		EType kind;
+	};
+
+	// one writer, its thread; head only grows, the slot is head & mask
+	struct Ring
+	{
+		std::unique_ptr<Event[]> events;
+		std::size_t mask;
+		std::atomic_size_t head{ 0 };
+
+		explicit Ring(std::size_t capacity)
+			: events(new Event[capacity])
+			, mask(capacity - 1)
+		{}
+	};
+
+	struct Registry
+	{
+		std::mutex mtx;
+		// a ring outlives its thread, the events are read after it is gone
+		std::vector<std::unique_ptr<Ring>> rings;
+		std::atomic_size_t capacity{ Trace::DefaultCapacity };
+	};
+
+	Registry& GetRegistry()
+	{
+		static Registry registry;
+		return registry;
+	}
+
+	thread_local Ring* ring_ = nullptr;
+
+	std::atomic_uint64_t nextId_{ 1 };
+
+	Ring* ThreadRing() noexcept
+	{
+		if (nullptr == ring_)
+		{
+			Registry& registry = GetRegistry();
+			std::unique_lock<std::mutex> lk(registry.mtx);
+			registry.rings.emplace_back(new Ring(registry.capacity.load(std::memory_order_relaxed)));
+			ring_ = registry.rings.back().get();
+		}
+		return ring_;
+	}
+
+	char const* EventName(ETraceEvent event) noexcept
+	{
+		switch (event)
+		{
+		case ETraceEvent::Spawn: return "spawn";
+		case ETraceEvent::Ready: return "ready";
+		case ETraceEvent::Resume: return "resume";
+		case ETraceEvent::Suspend: return "suspend";
+		case ETraceEvent::Yield: return "yield";
+		case ETraceEvent::Terminate: return "terminate";
+		case ETraceEvent::Migrate: return "migrate";
+		}
+		return "unknown";
+	}
+
+	// microseconds with the nanoseconds kept, the unit the format expects
+	void WriteTs(std::ostream& out, std::uint64_t ns)
+	{
+		out << ns / 1000 << '.';
+		const std::uint64_t frac = ns % 1000;
+		out << static_cast<char>('0' + frac / 100) << static_cast<char>('0' + frac / 10 % 10) << static_cast<char>('0' + frac % 10);
+	}
+
+	void WriteSliceName(std::ostream& out, Event const& e)
+	{
+		if (EType::DispatcherContext == e.kind)
+		{
+			out << "dispatcher";
+		}
+		else if (EType::MainContext == e.kind)
+		{
+			out << "main";
+		}
+		else
+		{
+			out << "fiber " << e.fiber;
+		}
+	}
+}
+
+std::atomic_bool Trace::recording_{ false };
+
+void Trace::Start(std::size_t eventsPerThread) noexcept
+{
+	std::size_t capacity = 1;
+	while (capacity < eventsPerThread)
+	{
+		capacity <<= 1;
+	}
+	GetRegistry().capacity.store(capacity, std::memory_order_relaxed);
+	recording_.store(true, std::memory_order_release);
+}
+
+void Trace::Stop() noexcept
+{
+	recording_.store(false, std::memory_order_release);
+}
+
+void Trace::Clear() noexcept
+{
+	Registry& registry = GetRegistry();
+	std::unique_lock<std::mutex> lk(registry.mtx);
+	for (std::unique_ptr<Ring>& ring : registry.rings)
+	{
+		ring->head.store(0, std::memory_order_relaxed);
+	}
+}
+
+std::uint64_t Trace::NextId() noexcept
+{
+	return nextId_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Trace::Append(ETraceEvent event, Context const* ctx, Scheduler const* sched) noexcept
+{
+	Ring* ring = ThreadRing();
+
+	Event e;
+	e.ts = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+#if defined(LUTASK_TRACE)
+	e.fiber = ctx->GetTraceId();
+#else
+	e.fiber = reinterpret_cast<std::uintptr_t>(ctx);
+#endif
+	e.scheduler = nullptr != sched ? sched->GetId() : 0;
+	e.event = event;
+	e.kind = ctx->IsContext(EType::DispatcherContext) ? EType::DispatcherContext
+		: ctx->IsContext(EType::MainContext) ? EType::MainContext : EType::WorkerContext;
+
+	const std::size_t head = ring->head.load(std::memory_order_relaxed);
+	ring->events[head & ring->mask] = e;
+	ring->head.store(head + 1, std::memory_order_release);
+}
+
+std::size_t Trace::WriteChromeJson(std::ostream& out)
+{
+	std::vector<Event> events;
+	{
+		Registry& registry = GetRegistry();
+		std::unique_lock<std::mutex> lk(registry.mtx);
+		for (std::unique_ptr<Ring>& ring : registry.rings)
+		{
+			const std::size_t head = ring->head.load(std::memory_order_acquire);
+			const std::size_t first = head > ring->mask + 1 ? head - ring->mask - 1 : 0;
+			for (std::size_t i = first; i < head; ++i)
+			{
+				events.push_back(ring->events[i & ring->mask]);
+			}
+		}
+	}
+	std::stable_sort(events.begin(), events.end(),
+		[](Event const& l, Event const& r) { return l.ts < r.ts; });
+
+	const std::uint64_t origin = events.empty() ? 0 : events.front().ts;
+	bool first = true;
+	auto begin = [&out, &first](char const* ph, std::uint32_t tid, std::uint64_t ts)
+	{
+		out << (first ? "\n" : ",\n") << "{\"ph\":\"" << ph << "\",\"pid\":1,\"tid\":" << tid << ",\"ts\":";
+		WriteTs(out, ts);
+		first = false;
+	};
+
+	out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+	// the context each scheduler is running and since when
+	std::unordered_map<std::uint32_t, Event> running;
+	// fibers between Ready and Resume
+	std::unordered_set<std::uint64_t> ready;
+	auto closeSlice = [&](std::uint32_t tid, std::uint64_t until)
+	{
+		auto iter = running.find(tid);
+		if (running.end() == iter)
+			return;
+
+		Event const& slice = iter->second;
+		begin("X", tid, slice.ts - origin);
+		out << ",\"dur\":";
+		WriteTs(out, until - slice.ts);
+		out << ",\"name\":\"";
+		WriteSliceName(out, slice);
+		out << "\",\"args\":{\"fiber\":" << slice.fiber << "}}";
+		running.erase(iter);
+	};
+
+	for (Event const& e : events)
+	{
+		switch (e.event)
+		{
+		case ETraceEvent::Resume:
+			closeSlice(e.scheduler, e.ts);
+			running[e.scheduler] = e;
+			if (ready.erase(e.fiber) != 0)
+			{
+				begin("e", e.scheduler, e.ts - origin);
+				out << ",\"cat\":\"ready\",\"name\":\"ready\",\"id\":" << e.fiber << "}";
+			}
+			break;
+		case ETraceEvent::Ready:
+			// a fiber is ready once, a second Ready is the same wait
+			if (ready.insert(e.fiber).second)
+			{
+				begin("b", e.scheduler, e.ts - origin);
+				out << ",\"cat\":\"ready\",\"name\":\"ready\",\"id\":" << e.fiber << "}";
+			}
+			break;
+		default:
+			begin("i", e.scheduler, e.ts - origin);
+			out << ",\"s\":\"t\",\"name\":\"" << EventName(e.event) << "\",\"args\":{\"fiber\":" << e.fiber << "}}";
+			break;
+		}
+	}
+
+	// still running when the recording ended
+	const std::uint64_t last = events.empty() ? 0 : events.back().ts;
+	std::set<std::uint32_t> tids;
+	for (Event const& e : events)
+	{
+		tids.insert(e.scheduler);
+	}
+	for (std::uint32_t tid : tids)
+	{
+		closeSlice(tid, last);
+	}
+	for (std::uint32_t tid : tids)
+	{
+		out << (first ? "\n" : ",\n") << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+			<< ",\"name\":\"thread_name\",\"args\":{\"name\":\"scheduler " << tid << "\"}}";
+		first = false;
+	}
+	out << "\n]}\n";
+	return events.size();
+}
+
+bool Trace::WriteChromeJson(char const* path)
+{
+	std::ofstream out(path);
+	if (!out)
+		return false;
+
+	WriteChromeJson(out);
+	return static_cast<bool>(out);
+}
+
+}
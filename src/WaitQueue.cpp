@@ -3,43 +3,75 @@
 
 namespace lutask
 {
-void WaitQueue::SuspendAndWait(Context* activeCtx)
+void WaitQueue::SuspendAndWait(std::unique_lock<std::mutex>& lk, Context* activeCtx)
 {
-	waits_.push(activeCtx);
-	activeCtx->Suspend();
+	waits_.PushBack(activeCtx);
+	activeCtx->Suspend(lk);
 }
 
-void WaitQueue::SuspendAndWait(std::unique_lock<std::mutex>& lk, Context* activeCtx)
+void WaitQueue::SuspendAndWait(std::unique_lock<detail::Spinlock>& lk, Context* activeCtx)
 {
-	waits_.push(activeCtx);
+	waits_.PushBack(activeCtx);
 	activeCtx->Suspend(lk);
 }
 
-void WaitQueue::NotifyOne()
+bool WaitQueue::SuspendAndWaitUntil(std::unique_lock<std::mutex>& lk, Context* activeCtx,
+	std::chrono::steady_clock::time_point const& tp)
+{
+	return SuspendAndWaitUntil_(lk, activeCtx, tp);
+}
+
+bool WaitQueue::SuspendAndWaitUntil(std::unique_lock<detail::Spinlock>& lk, Context* activeCtx,
+	std::chrono::steady_clock::time_point const& tp)
+{
+	return SuspendAndWaitUntil_(lk, activeCtx, tp);
+}
+
+template<typename Lock>
+bool WaitQueue::SuspendAndWaitUntil_(Lock& lk, Context* activeCtx,
+	std::chrono::steady_clock::time_point const& tp)
+{
+	waits_.PushBack(activeCtx);
+	activeCtx->wait_.store(EWait::Timed, std::memory_order_release);
+	activeCtx->WaitUntil(tp, lk);
+
+	lk.lock();
+	// a notifier may have dequeued us and lost to the deadline, that is a timeout too
+	const bool notified = EWait::Expired != activeCtx->wait_.load(std::memory_order_relaxed);
+	activeCtx->wait_.store(EWait::None, std::memory_order_relaxed);
+	if (static_cast<detail::ListHook<WaitHookTag>*>(activeCtx)->IsLinked())
+	{
+		waits_.Remove(activeCtx);
+		return false;
+	}
+	return notified;
+}
+
+Context* WaitQueue::NotifyOne()
 {
-	while (waits_.empty() == false)
+	while (waits_.IsEmpty() == false)
 	{
-		Context* ctx = waits_.front();
-		waits_.pop();
+		Context* ctx = waits_.PopFront();
 
+		// a timed waiter may have been claimed by its deadline already
 		if (ctx->Wake())
-			break;
+			return ctx;
 	}
+	return nullptr;
 }
 
 void WaitQueue::NotifyAll()
 {
-	while (waits_.empty() == false)
+	while (waits_.IsEmpty() == false)
 	{
-		Context* ctx = waits_.front();
-		waits_.pop();
+		Context* ctx = waits_.PopFront();
 		ctx->Wake();
 	}
 }
 
 bool WaitQueue::IsEmpty() const
 {
-	return waits_.empty();
+	return waits_.IsEmpty();
 }
 
 }
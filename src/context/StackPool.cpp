@@ -0,0 +1,166 @@
+#include <lutask/context/PooledFixedSizeStack.h>
+#include <lutask/Topology.h>
+#include <lutask/detail/BlockCache.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace lutask {
+namespace context {
+
+namespace
+{
+	struct PoolTraits
+	{
+		static constexpr std::size_t Classes = 4;
+		// nodes beyond the last one share its lists
+		static constexpr std::size_t Shards = 8;
+		static constexpr std::size_t LocalCapacity = StackPool::LocalCapacity;
+		static constexpr std::size_t GlobalCapacity = StackPool::GlobalCapacity;
+		static constexpr bool TrackHighWater = true;
+
+		static std::size_t CurrentShard() noexcept
+		{
+			return Topology::CurrentNode();
+		}
+
+		static void Release(void* vp) noexcept;
+	};
+
+	using Cache = lutask::detail::BlockCache<PoolTraits>;
+
+	// the stack sizes in use, a size claims a class the first time it is seen;
+	// stacks of sizes beyond the first Classes ones are not pooled
+	std::atomic_size_t classSizes[PoolTraits::Classes];
+
+	std::size_t ClassOf(std::size_t size) noexcept
+	{
+		for (std::size_t cls = 0; cls < PoolTraits::Classes; ++cls)
+		{
+			std::size_t current = classSizes[cls].load(std::memory_order_acquire);
+			if (0 == current && classSizes[cls].compare_exchange_strong(current, size, std::memory_order_acq_rel))
+				return cls;
+			if (size == current)
+				return cls;
+		}
+		return PoolTraits::Classes;
+	}
+
+	// every stack is preceded by a header naming the node its pages belong
+	// to, so a stack freed on another node goes back to its own node's list;
+	// the free list links live in the stack itself and leave it alone
+	struct alignas(alignof(std::max_align_t)) BlockHeader
+	{
+		std::size_t node;
+		// length of the stack's own mapping, 0 if it came from malloc
+		std::size_t mapped;
+	};
+
+	BlockHeader* HeaderOf(void* vp) noexcept
+	{
+		return reinterpret_cast<BlockHeader*>(static_cast<char*>(vp) - sizeof(BlockHeader));
+	}
+
+	void Free(void* vp) noexcept
+	{
+		BlockHeader* header = HeaderOf(vp);
+#if defined(__linux__)
+		if (0 != header->mapped)
+		{
+			::munmap(header, header->mapped);
+			return;
+		}
+#endif
+		std::free(header);
+	}
+
+	void PoolTraits::Release(void* vp) noexcept
+	{
+		Free(vp);
+	}
+
+	// on a multi-node machine a fresh stack gets a mapping of its own, bound
+	// to the allocating thread's node before any of its pages is touched, so
+	// they come from that node wherever the fiber runs first; heap blocks
+	// would share pages with their neighbours and may be faulted in already
+	void* AllocateLocal(std::size_t size) noexcept
+	{
+		const std::size_t node = Topology::CurrentNode();
+		void* vp = nullptr;
+		std::size_t mapped = 0;
+#if defined(__linux__)
+		if (1 < Topology::NodeCount())
+		{
+			const std::size_t pageSize = StackTraits::PageSize();
+			mapped = (sizeof(BlockHeader) + size + pageSize - 1) / pageSize * pageSize;
+			vp = ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (MAP_FAILED == vp)
+				return nullptr;
+
+			// refused, the stack still works with pages of whatever node
+			Topology::BindToNode(vp, mapped, node);
+		}
+		else
+#endif
+		{
+			vp = std::malloc(sizeof(BlockHeader) + size);
+			if (nullptr == vp)
+				return nullptr;
+		}
+
+		BlockHeader* header = ::new (vp) BlockHeader{ node, mapped };
+		return header + 1;
+	}
+}
+
+void* StackPool::Allocate(std::size_t size)
+{
+	assert(size >= Cache::MinBlockSize);
+
+	const std::size_t cls = ClassOf(size);
+	if (cls < PoolTraits::Classes)
+	{
+		if (void* vp = Cache::Pop(cls))
+			return vp;
+	}
+
+	void* vp = AllocateLocal(size);
+	if (!vp) {
+		throw std::bad_alloc();
+	}
+	return vp;
+}
+
+void StackPool::Deallocate(void* vp, std::size_t size) noexcept
+{
+	assert(nullptr != vp);
+
+	const std::size_t cls = ClassOf(size);
+	if (cls < PoolTraits::Classes)
+	{
+		Cache::Push(cls, HeaderOf(vp)->node, vp);
+	}
+	else
+	{
+		Free(vp);
+	}
+}
+
+StackPoolStats StackPool::Stats() noexcept
+{
+	lutask::detail::BlockCacheStats cache = Cache::Stats();
+
+	StackPoolStats stats;
+	stats.Hits = cache.Hits;
+	stats.Misses = cache.Misses;
+	stats.Cached = cache.Cached;
+	stats.HighWater = cache.HighWater;
+	return stats;
+}
+
+}}
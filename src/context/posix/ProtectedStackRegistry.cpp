@@ -0,0 +1,112 @@
+#include <lutask/context/posix/ProtectedFixedSizeStack.h>
+#include <algorithm>
+#include <mutex>
+
+extern "C" {
+#include <unistd.h>
+}
+
+namespace lutask {
+namespace context {
+
+namespace
+{
+	struct Registry
+	{
+		std::mutex mtx;
+		ProtectedStackHeader* stacks = nullptr;
+		std::size_t count = 0;
+		std::size_t reserved = 0;
+	};
+
+	Registry& Instance() noexcept
+	{
+		static Registry registry;
+		return registry;
+	}
+
+	// probes a chunk of pages at a time into a buffer of its own, so it
+	// never allocates and may run under the registry's mutex
+	std::size_t Resident(void* vp, std::size_t size) noexcept
+	{
+		constexpr std::size_t ChunkPages = 256;
+		const std::size_t pageSize = StackTraits::PageSize();
+		unsigned char pages[ChunkPages];
+
+		std::size_t resident = 0;
+		char* cp = static_cast<char*>(vp);
+		for (std::size_t offset = 0; offset < size; offset += ChunkPages * pageSize)
+		{
+			const std::size_t length = (std::min)(size - offset, ChunkPages * pageSize);
+#if defined(__APPLE__) || defined(__FreeBSD__)
+			if (0 != ::mincore(cp + offset, length, reinterpret_cast<char*>(pages)))
+#else
+			if (0 != ::mincore(cp + offset, length, pages))
+#endif
+			{
+				return resident;
+			}
+
+			for (std::size_t page = 0; page < (length + pageSize - 1) / pageSize; ++page)
+			{
+				if (pages[page] & 1)
+					resident += pageSize;
+			}
+		}
+		return resident;
+	}
+}
+
+void ProtectedStackRegistry::Register(ProtectedStackHeader* header) noexcept
+{
+	Registry& r = Instance();
+	std::unique_lock<std::mutex> lk(r.mtx);
+	++r.count;
+	r.reserved += header->size;
+	header->prev = nullptr;
+	header->next = r.stacks;
+	if (nullptr != r.stacks)
+	{
+		r.stacks->prev = header;
+	}
+	r.stacks = header;
+}
+
+void ProtectedStackRegistry::Unregister(ProtectedStackHeader* header) noexcept
+{
+	Registry& r = Instance();
+	std::unique_lock<std::mutex> lk(r.mtx);
+	--r.count;
+	r.reserved -= header->size;
+	(nullptr != header->prev ? header->prev->next : r.stacks) = header->next;
+	if (nullptr != header->next)
+	{
+		header->next->prev = header->prev;
+	}
+}
+
+std::size_t ProtectedStackRegistry::ResidentBytes(StackContext const& sctx) noexcept
+{
+	assert(sctx.Sp);
+
+	return Resident(static_cast<char*>(sctx.Sp) - sctx.Size, sctx.Size);
+}
+
+ProtectedStackStats ProtectedStackRegistry::Stats()
+{
+	Registry& r = Instance();
+
+	// one pass under the mutex: the count matches the stacks probed, and a
+	// registered range is still the stack's own mapping while mincore() looks
+	ProtectedStackStats stats;
+	std::unique_lock<std::mutex> lk(r.mtx);
+	stats.Stacks = r.count;
+	stats.ReservedBytes = r.reserved;
+	for (ProtectedStackHeader* header = r.stacks; nullptr != header; header = header->next)
+	{
+		stats.ResidentBytes += Resident(header->base, header->size);
+	}
+	return stats;
+}
+
+}}
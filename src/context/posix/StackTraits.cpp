@@ -0,0 +1,79 @@
+#include <lutask/context/StackTraits.h>
+#include <algorithm>
+#include <cassert>
+#include <exception>
+
+extern "C" {
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+}
+
+#if !defined(SIGSTKSZ)
+# define SIGSTKSZ (32768) // 32kb minimum allowable stack
+# define UDEF_SIGSTKSZ
+#endif
+
+#if !defined(MINSIGSTKSZ)
+# define MINSIGSTKSZ (131072) // 128kb recommended stack size
+# define UDEF_MINSIGSTKSZ
+#endif
+
+namespace 
+{
+	std::size_t pagesize() 
+	{
+		// conform to POSIX.1-2001
+		return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+	}
+
+	rlimit stacksize_limit() 
+	{
+		rlimit limit;
+		// conforming to POSIX.1-2001
+		const int result = ::getrlimit(RLIMIT_STACK, &limit);
+		assert(0 == result);
+		(void)result;
+		return limit;
+	}
+}
+
+bool lutask::StackTraits::IsUnbounded()
+{
+	static rlimit limit = stacksize_limit();
+	return RLIM_INFINITY == limit.rlim_max;
+}
+
+std::size_t lutask::StackTraits::PageSize()
+{
+	static std::size_t size = pagesize();
+	return size;
+}
+
+std::size_t lutask::StackTraits::DefaultSize()
+{
+	return (std::max)(static_cast<std::size_t>(64 * 1024), MinimumSize());
+}
+
+std::size_t lutask::StackTraits::MinimumSize()
+{
+	return MINSIGSTKSZ;
+}
+
+std::size_t lutask::StackTraits::MaximumSize()
+{
+	if (IsUnbounded())
+		throw std::exception();
+
+	static rlimit limit = stacksize_limit();
+	return static_cast<std::size_t>(limit.rlim_max);
+}
+
+#ifdef UDEF_SIGSTKSZ
+# undef SIGSTKSZ
+#endif
+
+#ifdef UDEF_MINSIGSTKSZ
+# undef MINSIGSTKSZ
+#endif
@@ -0,0 +1,160 @@
+#include <lutask/schedule/EdfPolicy.h>
+#include <cassert>
+#include <lutask/detail/OwnerCounter.h>
+
+namespace lutask {
+namespace schedule {
+
+std::atomic_size_t EdfPolicy::totalMisses_{ 0 };
+
+// readySlot_ is the heap index plus one while the context is in the heap
+
+void EdfPolicy::Place(std::size_t index, Entry const& entry) noexcept
+{
+	heap_[index] = entry;
+	entry.ctx->readySlot_ = static_cast<std::uint32_t>(index + 1);
+}
+
+void EdfPolicy::SiftUp(std::size_t index) noexcept
+{
+	Entry entry = heap_[index];
+	while (0 < index)
+	{
+		std::size_t parent = (index - 1) / 2;
+		if (Earlier(entry, heap_[parent]) == false)
+			break;
+
+		Place(index, heap_[parent]);
+		index = parent;
+	}
+	Place(index, entry);
+}
+
+void EdfPolicy::SiftDown(std::size_t index) noexcept
+{
+	Entry entry = heap_[index];
+	const std::size_t size = heap_.size();
+	for (;;)
+	{
+		std::size_t child = 2 * index + 1;
+		if (size <= child)
+			break;
+		if (child + 1 < size && Earlier(heap_[child + 1], heap_[child]))
+		{
+			++child;
+		}
+		if (Earlier(heap_[child], entry) == false)
+			break;
+
+		Place(index, heap_[child]);
+		index = child;
+	}
+	Place(index, entry);
+}
+
+EdfPolicy::Entry EdfPolicy::RemoveAt(std::size_t index) noexcept
+{
+	Entry entry = heap_[index];
+	entry.ctx->readySlot_ = 0;
+
+	Entry last = heap_.back();
+	heap_.pop_back();
+	if (index < heap_.size())
+	{
+		Place(index, last);
+		SiftUp(index);
+		SiftDown(last.ctx->readySlot_ - 1);
+	}
+	return entry;
+}
+
+void EdfPolicy::Awakened(Context* ctx) noexcept
+{
+	assert(nullptr != ctx);
+	assert(ctx->IsResumable());
+
+	const TimePoint deadline = ctx->GetDeadline();
+	if ((TimePoint::max)() == deadline)
+	{
+		bestEffort_.PushBack(ctx);
+		return;
+	}
+
+	// grows to the peak number of ready deadline fibers once, then stays
+	heap_.push_back(Entry{ deadline, seq_++, ctx });
+	SiftUp(heap_.size() - 1);
+}
+
+Context* EdfPolicy::PickNext() noexcept
+{
+	if (heap_.empty() == false && (bestEffort_.IsEmpty() || ++passedOver_ < AgingLimit))
+	{
+		Entry entry = RemoveAt(0);
+		if (entry.deadline < std::chrono::steady_clock::now())
+		{
+			detail::Bump(misses_);
+			totalMisses_.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		assert(entry.ctx->IsResumable());
+		return entry.ctx;
+	}
+
+	passedOver_ = 0;
+	Context* ctx = bestEffort_.PopFront();
+	assert(nullptr == ctx || ctx->IsResumable());
+	return ctx;
+}
+
+void EdfPolicy::PriorityChanged(Context* ctx) noexcept
+{
+	assert(nullptr != ctx);
+
+	// a running or waiting context is queued by its new deadline when woken;
+	// the slot may be left over from another policy, it counts only if it matches
+	const std::size_t slot = ctx->readySlot_;
+	if (0 != slot && slot <= heap_.size() && ctx == heap_[slot - 1].ctx)
+	{
+		RemoveAt(slot - 1);
+	}
+	else if (static_cast<detail::ListHook<ReadyHookTag>*>(ctx)->IsLinked())
+	{
+		bestEffort_.Remove(ctx);
+	}
+	else
+	{
+		return;
+	}
+	Awakened(ctx);
+}
+
+bool EdfPolicy::HasReadyFibers() const noexcept
+{
+	return heap_.empty() == false || bestEffort_.IsEmpty() == false;
+}
+
+void EdfPolicy::SuspendUntil(TimePoint const& timePoint) noexcept
+{
+	if ((std::chrono::steady_clock::time_point::max)() == timePoint) 
+	{
+		std::unique_lock<std::mutex> lk{ mtx_ };
+		cnd_.wait(lk, [&]() { return flag_; });
+		flag_ = false;
+	}
+	else 
+	{
+		std::unique_lock<std::mutex> lk{ mtx_ };
+		cnd_.wait_until(lk, timePoint, [&]() { return flag_; });
+		flag_ = false;
+	}
+}
+
+void EdfPolicy::Notify() noexcept
+{
+	std::unique_lock<std::mutex> lk{ mtx_ };
+	flag_ = true;
+	lk.unlock();
+	cnd_.notify_all();
+}
+
+}}
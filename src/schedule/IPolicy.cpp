@@ -0,0 +1,40 @@
+#include <lutask/schedule/IPolicy.h>
+#include <lutask/Context.h>
+
+namespace lutask {
+namespace schedule {
+
+void IPolicy::AwakenedAsync(Context* ctx) noexcept
+{
+	// a policy that does not share fibers runs it here, as if posted
+	Context::Active()->Attach(ctx);
+	Awakened(ctx);
+}
+
+void IPolicy::AwakenedBatch(Context* const* ctxs, std::size_t count) noexcept
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		Awakened(ctxs[i]);
+	}
+}
+
+void IPolicy::AwakenedAsyncBatch(Context* const* ctxs, std::size_t count) noexcept
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		AwakenedAsync(ctxs[i]);
+	}
+}
+
+void IPolicy::PriorityChanged(Context*) noexcept
+{
+	// policies that ignore priorities have nothing to move
+}
+
+bool IPolicy::DetachesAwakened() const noexcept
+{
+	return false;
+}
+
+}}
@@ -0,0 +1,109 @@
+#include <lutask/schedule/PriorityPolicy.h>
+#include <cassert>
+
+namespace lutask {
+namespace schedule {
+
+void PriorityPolicy::Awakened(Context* ctx) noexcept
+{
+	assert(nullptr != ctx);
+	assert(ctx->IsResumable());
+
+	const std::size_t band = static_cast<std::size_t>(ctx->GetPriority());
+	assert(band < BandCount);
+
+	ctx->readySlot_ = static_cast<std::uint32_t>(band);
+	bands_[band].PushBack(ctx);
+	bitmap_ |= 1u << band;
+}
+
+Context* PriorityPolicy::PickNext() noexcept
+{
+	if (0 == bitmap_)
+	{
+		return nullptr;
+	}
+
+	std::size_t band = BandCount - 1;
+	while (0 == (bitmap_ & (1u << band)))
+	{
+		--band;
+	}
+
+	// every band below the chosen one that has work waits one more turn,
+	// the lowest that waited too long takes this one instead
+	for (std::size_t lower = 0; lower < band; ++lower)
+	{
+		if (0 != (bitmap_ & (1u << lower)) && AgingLimit <= ++passedOver_[lower])
+		{
+			band = lower;
+			break;
+		}
+	}
+	passedOver_[band] = 0;
+
+	Context* ctx = bands_[band].PopFront();
+	if (bands_[band].IsEmpty())
+	{
+		bitmap_ &= ~(1u << band);
+	}
+
+	assert(nullptr != ctx);
+	assert(ctx->IsResumable());
+	return ctx;
+}
+
+void PriorityPolicy::Unlink(Context* ctx) noexcept
+{
+	const std::size_t band = ctx->readySlot_;
+	bands_[band].Remove(ctx);
+	if (bands_[band].IsEmpty())
+	{
+		bitmap_ &= ~(1u << band);
+		passedOver_[band] = 0;
+	}
+}
+
+void PriorityPolicy::PriorityChanged(Context* ctx) noexcept
+{
+	assert(nullptr != ctx);
+
+	// only a ready context sits in a band, a running or waiting one is
+	// queued by its new priority when it is woken
+	if (static_cast<detail::ListHook<ReadyHookTag>*>(ctx)->IsLinked())
+	{
+		Unlink(ctx);
+		Awakened(ctx);
+	}
+}
+
+bool PriorityPolicy::HasReadyFibers() const noexcept
+{
+	return 0 != bitmap_;
+}
+
+void PriorityPolicy::SuspendUntil(TimePoint const& timePoint) noexcept
+{
+	if ((std::chrono::steady_clock::time_point::max)() == timePoint) 
+	{
+		std::unique_lock<std::mutex> lk{ mtx_ };
+		cnd_.wait(lk, [&]() { return flag_; });
+		flag_ = false;
+	}
+	else 
+	{
+		std::unique_lock<std::mutex> lk{ mtx_ };
+		cnd_.wait_until(lk, timePoint, [&]() { return flag_; });
+		flag_ = false;
+	}
+}
+
+void PriorityPolicy::Notify() noexcept
+{
+	std::unique_lock<std::mutex> lk{ mtx_ };
+	flag_ = true;
+	lk.unlock();
+	cnd_.notify_all();
+}
+
+}}
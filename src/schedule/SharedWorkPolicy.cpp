@@ -5,54 +5,41 @@
 namespace lutask {
 namespace schedule {
 
-std::queue<Context*> SharedWorkPolicy::readyQueue_;
+detail::MPMCQueue<Context*> SharedWorkPolicy::readyQueue_;
 std::mutex SharedWorkPolicy::rqueueMutex_;
 
 void SharedWorkPolicy::Awakened(Context* ctx) noexcept
 {
 	if (ctx->IsContext(EType::PinnedContext))
 	{
-		localQueue_.push(ctx);
+		localQueue_.PushBack(ctx);
 	}
 	else
 	{
 		ctx->Detach();
-
-		std::unique_lock<std::mutex> lk(rqueueMutex_);
-		readyQueue_.push(ctx);
+		readyQueue_.Push(ctx);
 	}
 }
 
 Context* SharedWorkPolicy::PickNext() noexcept
 {
 	Context* ctx = nullptr;
-	std::unique_lock<std::mutex> lk(rqueueMutex_);
-	if (readyQueue_.empty() == false)
+	if (readyQueue_.TryPop(ctx))
 	{
-		ctx = readyQueue_.front();
-		readyQueue_.pop();
-		lk.unlock();
-
 		assert(ctx != nullptr);
 
 		Context::Active()->Attach(ctx);
 	}
 	else
 	{
-		lk.unlock();
-		if (localQueue_.empty() == false)
-		{
-			ctx = localQueue_.front();
-			localQueue_.pop();
-		}
+		ctx = localQueue_.PopFront();
 	}
 	return ctx;
 }
 
 bool SharedWorkPolicy::HasReadyFibers() const noexcept
 {
-	std::unique_lock<std::mutex> lk(rqueueMutex_);
-	return !readyQueue_.empty() || !localQueue_.empty();
+	return !readyQueue_.IsEmpty() || !localQueue_.IsEmpty();
 }
 
 void SharedWorkPolicy::SuspendUntil(TimePoint const& time_point) noexcept
@@ -86,10 +73,14 @@ void SharedWorkPolicy::Notify() noexcept
 }
 
 void SharedWorkPolicy::AwakenedAsync(Context* ctx) noexcept
+{
+	EnqueueShared(ctx);
+}
+
+void SharedWorkPolicy::EnqueueShared(Context* ctx) noexcept
 {
 	ctx->Detach();
-	std::unique_lock<std::mutex> lk(rqueueMutex_);
-	readyQueue_.push(ctx);
+	readyQueue_.Push(ctx);
 }
 
 }}
\ No newline at end of file
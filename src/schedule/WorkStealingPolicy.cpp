@@ -0,0 +1,280 @@
+#include <lutask/schedule/WorkStealingPolicy.h>
+#include <lutask/Scheduler.h>
+#include <lutask/Context.h>
+#include <lutask/Topology.h>
+
+namespace lutask {
+namespace schedule {
+
+std::shared_ptr<WorkStealingGroup> const& WorkStealingGroup::Default()
+{
+	static const std::shared_ptr<WorkStealingGroup> group = std::make_shared<WorkStealingGroup>();
+	return group;
+}
+
+std::size_t WorkStealingGroup::Register(WorkStealingPolicy* worker) noexcept
+{
+	// the slots of finished workers are taken again
+	for (std::size_t id = 0; id < MaxWorkers; ++id)
+	{
+		WorkStealingPolicy* expected = nullptr;
+		if (workers_[id].load(std::memory_order_relaxed) == nullptr
+			&& workers_[id].compare_exchange_strong(expected, worker, std::memory_order_acq_rel))
+		{
+			std::size_t count = workerCount_.load(std::memory_order_relaxed);
+			while (count <= id && workerCount_.compare_exchange_weak(count, id + 1, std::memory_order_acq_rel) == false)
+			{
+			}
+			return id;
+		}
+	}
+	// every slot is taken: the worker runs its own fibers and steals, but
+	// nobody can steal from it or wake it for new work
+	return MaxWorkers;
+}
+
+void WorkStealingGroup::Unregister(std::size_t id) noexcept
+{
+	if (id < MaxWorkers)
+	{
+		workers_[id].store(nullptr, std::memory_order_release);
+	}
+}
+
+WorkStealingPolicy::WorkStealingPolicy(bool suspend)
+	: WorkStealingPolicy(WorkStealingGroup::Default(), suspend)
+{
+}
+
+WorkStealingPolicy::WorkStealingPolicy(std::shared_ptr<WorkStealingGroup> group, bool suspend)
+	: group_(std::move(group))
+	, id_(group_->Register(this))
+	, node_(Topology::CurrentNode())
+	, rng_(static_cast<std::minstd_rand::result_type>(id_ + 1))
+	, suspend_(suspend)
+{
+}
+
+WorkStealingPolicy::~WorkStealingPolicy()
+{
+	group_->Unregister(id_);
+}
+
+void WorkStealingPolicy::Awakened(Context* ctx) noexcept
+{
+	if (ctx->IsContext(EType::PinnedContext))
+	{
+		localQueue_.push(ctx);
+	}
+	else
+	{
+		ctx->Detach();
+		deque_.Push(ctx);
+		NotifyIdle();
+	}
+}
+
+void WorkStealingPolicy::AwakenedAsync(Context* ctx) noexcept
+{
+	// lands on the spawning thread's deque, idle workers steal it from there
+	deque_.Push(ctx);
+	NotifyIdle();
+}
+
+void WorkStealingPolicy::AwakenedBatch(Context* const* ctxs, std::size_t count) noexcept
+{
+	std::size_t pushed = 0;
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		if (ctxs[i]->IsContext(EType::PinnedContext))
+		{
+			localQueue_.push(ctxs[i]);
+		}
+		else
+		{
+			ctxs[i]->Detach();
+			deque_.Push(ctxs[i]);
+			++pushed;
+		}
+	}
+	NotifyIdle(pushed);
+}
+
+void WorkStealingPolicy::AwakenedAsyncBatch(Context* const* ctxs, std::size_t count) noexcept
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		deque_.Push(ctxs[i]);
+	}
+	NotifyIdle(count);
+}
+
+Context* WorkStealingPolicy::PickNext() noexcept
+{
+	Context* ctx = nullptr;
+	Context* active = Context::Active();
+
+	// pinned contexts get a turn even while the deque stays busy
+	const std::size_t pick = ++pickCount_;
+	const bool pinnedTurn = localQueue_.empty() == false && 0 == pick % PinnedInterval;
+	if (pinnedTurn == false)
+	{
+		// the owner pops the newest fiber without a CAS and while its stack
+		// is still warm; every OldestInterval-th pick takes the oldest one,
+		// so fibers that keep yielding to each other can not starve the rest
+		ctx = 0 == pick % OldestInterval ? deque_.Steal() : nullptr;
+		if (nullptr == ctx)
+		{
+			ctx = deque_.Pop();
+		}
+		if (nullptr != ctx)
+		{
+			active->Attach(ctx);
+			return ctx;
+		}
+	}
+
+	// only the dispatcher goes stealing, everyone else hands over to it first
+	if (localQueue_.empty() == false && (pinnedTurn || !active->IsContext(EType::DispatcherContext)))
+	{
+		ctx = localQueue_.front();
+		localQueue_.pop();
+		return ctx;
+	}
+
+	ctx = Steal();
+	if (nullptr != ctx)
+	{
+		assert(ctx->IsContext(EType::PinnedContext) == false);
+		active->Attach(ctx);
+		return ctx;
+	}
+
+	if (localQueue_.empty() == false)
+	{
+		ctx = localQueue_.front();
+		localQueue_.pop();
+	}
+	return ctx;
+}
+
+Context* WorkStealingPolicy::Steal() noexcept
+{
+	// an unregistered worker has no slot of its own among them
+	const std::size_t count = (std::min)(group_->workerCount_.load(std::memory_order_acquire), MaxWorkers);
+	if (count < (id_ < MaxWorkers ? 2u : 1u))
+	{
+		return nullptr;
+	}
+
+	// a fiber that crosses nodes leaves its stack behind on remote memory,
+	// other nodes are only tried once every victim of our own came up empty
+	Context* ctx = StealFrom(count, true);
+	if (nullptr == ctx && 1 < Topology::NodeCount())
+	{
+		ctx = StealFrom(count, false);
+	}
+	return ctx;
+}
+
+Context* WorkStealingPolicy::StealFrom(std::size_t count, bool sameNode) noexcept
+{
+	// one pass over all workers from a random start, so no victim is probed twice
+	std::uniform_int_distribution<std::size_t> distribution{ 0, count - 1 };
+	const std::size_t start = distribution(rng_);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		std::size_t victimId = (start + i) % count;
+		if (victimId == id_)
+		{
+			continue;
+		}
+
+		WorkStealingPolicy* victim = group_->workers_[victimId].load(std::memory_order_acquire);
+		if (nullptr == victim || (victim->node_ == node_) != sameNode)
+		{
+			continue;
+		}
+
+		Context* ctx = victim->deque_.Steal();
+		if (nullptr != ctx)
+		{
+			Topology::CountSteal(node_, victim->node_);
+			Context::Active()->GetScheduler()->CountSteal();
+			return ctx;
+		}
+	}
+	return nullptr;
+}
+
+bool WorkStealingPolicy::HasReadyFibers() const noexcept
+{
+	return !deque_.IsEmpty() || !localQueue_.empty();
+}
+
+void WorkStealingPolicy::SuspendUntil(TimePoint const& timePoint) noexcept
+{
+	if (suspend_)
+	{
+		sleeping_.store(true, std::memory_order_relaxed);
+		group_->sleepingCount_.fetch_add(1, std::memory_order_seq_cst);
+
+		// nobody wakes an unregistered worker for stealable work, it polls
+		if (MaxWorkers <= id_)
+		{
+			std::unique_lock<std::mutex> lk(mtx_);
+			cnd_.wait_until(lk, (std::min)(timePoint, std::chrono::steady_clock::now() + std::chrono::milliseconds(1)),
+				[this]() { return flag_; });
+			flag_ = false;
+		}
+		else if (std::chrono::steady_clock::time_point::max() == timePoint)
+		{
+			std::unique_lock<std::mutex> lk(mtx_);
+			cnd_.wait(lk, [this]() { return flag_; });
+			flag_ = false;
+		}
+		else
+		{
+			std::unique_lock<std::mutex> lk(mtx_);
+			cnd_.wait_until(lk, timePoint, [this]() { return flag_; });
+			flag_ = false;
+		}
+
+		group_->sleepingCount_.fetch_sub(1, std::memory_order_relaxed);
+		sleeping_.store(false, std::memory_order_relaxed);
+	}
+}
+
+void WorkStealingPolicy::Notify() noexcept
+{
+	if (suspend_)
+	{
+		std::unique_lock<std::mutex> lk(mtx_);
+		flag_ = true;
+		lk.unlock();
+		cnd_.notify_all();
+	}
+}
+
+void WorkStealingPolicy::NotifyIdle(std::size_t count) noexcept
+{
+	// new work is stealable, wake as many sleeping workers of the group as
+	// there are fibers to take, one scan serves a whole batch
+	if (0 == count || 0 == group_->sleepingCount_.load(std::memory_order_seq_cst))
+	{
+		return;
+	}
+
+	const std::size_t workers = (std::min)(group_->workerCount_.load(std::memory_order_acquire), MaxWorkers);
+	for (std::size_t i = 0; i < workers && 0 < count; ++i)
+	{
+		WorkStealingPolicy* worker = group_->workers_[i].load(std::memory_order_acquire);
+		if (nullptr != worker && worker != this && worker->sleeping_.load(std::memory_order_relaxed))
+		{
+			worker->Notify();
+			--count;
+		}
+	}
+}
+
+}}